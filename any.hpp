@@ -1,35 +1,313 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <limits>
 #include <memory>
 #include <cstring>
 #include <type_traits>
+#include <tuple>
 #include <typeinfo>
-#include <typeindex>
+#include <utility>
 #include <cassert>
-#include <sstream>
+#include <stdexcept>
 #include <string>
 
+#if defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+
+#if defined(__cpp_lib_bit_cast)
+#include <bit>
+#endif
+
+// static_any_t can be constructed at compile time if std::bit_cast and std::is_constant_evaluated are available (C++20)
+#if defined(__cpp_lib_bit_cast) && defined(__cpp_lib_is_constant_evaluated)
+#define STATIC_ANY_CONSTEXPR_ANY_T 1
+#define STATIC_ANY_CONSTEXPR constexpr
+#else
+#define STATIC_ANY_CONSTEXPR_ANY_T 0
+#define STATIC_ANY_CONSTEXPR
+#endif
+
 namespace detail { namespace static_any {
 
 struct move_tag {};
 struct copy_tag {};
 
-enum class operation_t { query_type, query_size, copy, move, destroy };
+template <class _T>
+struct is_trivially_copyable :
+#if __GNUG__ && __GNUC__ < 5
+	public std::integral_constant<bool, std::has_trivial_copy_constructor<_T>::value>
+#else
+	public std::integral_constant<bool, std::is_trivially_copyable<_T>::value>
+#endif
+{};
+
+// trivial types are copied, moved and destroyed inline, without calling through the function table
+template <class _T>
+struct is_trivial_operation :
+	public std::integral_constant<bool, is_trivially_copyable<_T>::value &&
+										std::is_copy_constructible<_T>::value &&
+										std::is_trivially_destructible<_T>::value>
+{};
+
+template <class...>
+using void_t = void;
+
+constexpr bool all_of(std::initializer_list<bool> values)
+{
+	for (bool value : values)
+		if (!value)
+			return false;
+	return true;
+}
+
+template <class _T, class = void>
+struct has_equal_operator : public std::false_type {};
+
+template <class _T>
+struct has_equal_operator<_T, std::enable_if_t<std::is_convertible<decltype(std::declval<const _T&>() == std::declval<const _T&>()), bool>::value>> :
+	public std::true_type {};
+
+template <class _T, class = void>
+struct has_less_operator : public std::false_type {};
+
+template <class _T>
+struct has_less_operator<_T, std::enable_if_t<std::is_convertible<decltype(std::declval<const _T&>() < std::declval<const _T&>()), bool>::value>> :
+	public std::true_type {};
+
+// The comparison operators of the standard containers, std::pair and std::tuple are declared for any elements, but fail
+// to compile for elements without them: the elements are checked too, recursively
+template <template <class...> class _HasOperator, class _T, class = void>
+struct is_comparable_with : public _HasOperator<_T> {};
+
+template <template <class...> class _HasOperator, class _T>
+struct is_comparable_with<_HasOperator, _T, void_t<typename _T::value_type>> :
+	public std::integral_constant<bool, _HasOperator<_T>::value &&
+										(std::is_same<std::remove_cv_t<typename _T::value_type>, _T>::value ||
+										 is_comparable_with<_HasOperator, std::remove_cv_t<typename _T::value_type>>::value)>
+{};
+
+template <template <class...> class _HasOperator, class _T1, class _T2>
+struct is_comparable_with<_HasOperator, std::pair<_T1, _T2>, void> :
+	public std::integral_constant<bool, is_comparable_with<_HasOperator, std::remove_cv_t<_T1>>::value &&
+										is_comparable_with<_HasOperator, std::remove_cv_t<_T2>>::value>
+{};
+
+template <template <class...> class _HasOperator, class... _Ts>
+struct is_comparable_with<_HasOperator, std::tuple<_Ts...>, void> :
+	public std::integral_constant<bool, all_of({ is_comparable_with<_HasOperator, std::remove_cv_t<_Ts>>::value... })>
+{};
+
+template <class _T>
+struct is_equality_comparable : public is_comparable_with<has_equal_operator, _T> {};
+
+template <class _T>
+struct is_less_comparable : public is_comparable_with<has_less_operator, _T> {};
+
+
+// std::hash<_T> is disabled (not default constructible) for the types it does not support
+template <class _T, class = void>
+struct is_hashable : public std::false_type {};
+
+template <class _T>
+struct is_hashable<_T, std::enable_if_t<std::is_default_constructible<std::hash<_T>>::value &&
+										std::is_convertible<decltype(std::hash<_T>()(std::declval<const _T&>())), std::size_t>::value>> :
+	public std::true_type {};
+
+// up to this size, copying the whole buffer compiles to a few inlined moves and is cheaper than a memcpy
+// of the stored size only
+static constexpr std::size_t trivial_copy_max_buffer_size = 64;
+
+using type_hash_t = std::uint64_t;
+
+// FNV-1a hash of the signature of type_hash<_T>, which contains the name of _T: unlike the address of a
+// function table or of a std::type_info, it is identical in every module built with the same compiler, and
+// comparing it is a single integer comparison. Two distinct types can print the same name (two lambdas of a
+// function, types of anonymous namespaces of different translation units): a matching hash is confirmed with
+// the std::type_info of the types, see is_function_for_type
+template <class _T>
+constexpr type_hash_t type_hash()
+{
+#if defined(_MSC_VER)
+	const char* name = __FUNCSIG__;
+#else
+	const char* name = __PRETTY_FUNCTION__;
+#endif
+
+	type_hash_t hash = 14695981039346656037ull;
+	for (; *name != '\0'; ++name)
+	{
+		hash ^= static_cast<unsigned char>(*name);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+template <class _T>
+constexpr type_hash_t type_hash_v = type_hash<std::remove_cv_t<std::remove_reference_t<_T>>>();
+
+template <std::size_t _M>
+inline void trivial_copy(void* this_ptr, const void* other_ptr, std::size_t size)
+{
+	std::memcpy(this_ptr, other_ptr, _M <= trivial_copy_max_buffer_size ? _M : size);
+}
+
+#if STATIC_ANY_CONSTEXPR_ANY_T
+// the bytes of t at the beginning of a buffer of _N bytes, the others being zeroed. Constant expression as long as _T
+// has no padding bytes, whose value is indeterminate
+template <std::size_t _N, class _T>
+constexpr std::array<char, _N> to_buffer(const _T& t)
+{
+	const auto bytes = std::bit_cast<std::array<char, sizeof(_T)>>(t);
+
+	std::array<char, _N> buff{};
+	for (std::size_t i = 0; i < sizeof(_T); ++i)
+		buff[i] = bytes[i];
+	return buff;
+}
+
+template <class _T, std::size_t _N>
+constexpr _T from_buffer(const std::array<char, _N>& buff)
+{
+	std::array<char, sizeof(_T)> bytes{};
+	for (std::size_t i = 0; i < sizeof(_T); ++i)
+		bytes[i] = buff[i];
+	return std::bit_cast<_T>(bytes);
+}
+#endif
+
+// events counted when STATIC_ANY_INSTRUMENTATION is defined, see static_any_counters
+enum class counter
+{
+	copy,            // a value copied from an any to another
+	move,            // a value moved from an any to another
+	slow_type_check, // a type identified by its hash, its function table coming from another module
+	bad_cast,        // a bad_any_cast thrown
+	backup           // a copy or move of the previous value, by an assignment whose construction can throw
+};
+
+constexpr std::size_t counter_count = 5;
+
+#if defined(STATIC_ANY_INSTRUMENTATION)
+
+struct counters_t
+{
+	std::atomic<std::uint64_t> values[counter_count];
+};
+
+// counters_for<void>: all the types
+template <class _T>
+struct counters_for
+{
+	static counters_t value;
+};
+
+template <class _T>
+counters_t counters_for<_T>::value;
+
+#endif
+
+struct function_table_t
+{
+	void (*copy)(void* this_ptr, const void* other_ptr);
+	void (*move)(void* this_ptr, void* other_ptr);
+	void (*destroy)(void* this_ptr);
+
+	// moves the value from other_ptr to this_ptr and destroys it there, a single call instead of move and destroy
+	void (*relocate)(void* this_ptr, void* other_ptr);
+
+	// nullptr if the type is not equality comparable, has no operator<, or is not supported by std::hash
+	bool (*equal)(const void* this_ptr, const void* other_ptr);
+	bool (*less)(const void* this_ptr, const void* other_ptr);
+	std::size_t (*hash)(const void* this_ptr);
+
+	const std::type_info* type;
+	type_hash_t type_hash;
+	std::size_t size;
+	std::size_t alignment;
+
+	bool trivial;
+	bool relocatable; // trivially: relocation is a memcpy, see static_any_trivially_relocatable
+	bool copyable;
+	bool nothrow_copy;
+	bool nothrow_move;
+
+#if defined(STATIC_ANY_INSTRUMENTATION)
+	counters_t* counters;
+#endif
+};
+
+using function_table_ptr_t = const function_table_t*;
+
+// counts c for all the types and, if there is one, for the type of function; nothing without instrumentation
+#if defined(STATIC_ANY_INSTRUMENTATION)
+inline void count(function_table_ptr_t function, counter c)
+{
+	const std::size_t i = static_cast<std::size_t>(c);
+	counters_for<void>::value.values[i].fetch_add(1, std::memory_order_relaxed);
+	if (function != nullptr)
+		function->counters->values[i].fetch_add(1, std::memory_order_relaxed);
+}
+#else
+inline void count(function_table_ptr_t, counter) {}
+#endif
 
-using function_ptr_t = void(*)(operation_t operation, void* this_ptr, void* other_ptr);
+inline void count(function_table_ptr_t function, move_tag) { count(function, counter::move); }
+inline void count(function_table_ptr_t function, copy_tag) { count(function, counter::copy); }
+
+struct any_access;
+
+// alignof(std::max_align_t), or less for small buffers: a type cannot be more aligned than its size
+constexpr std::size_t default_alignment(std::size_t size)
+{
+	std::size_t alignment = 1;
+	while (alignment * 2 <= size && alignment * 2 <= alignof(std::max_align_t))
+		alignment *= 2;
+	return alignment;
+}
 
 }}
 
-template <std::size_t _N>
+// Types whose values can be moved to another address with a memcpy, the source being then forgotten instead of destroyed:
+// moving or swapping anys storing them is a byte copy. Trivially copyable types are; others, e.g. std::unique_ptr or
+// std::vector, can be declared so by specializing this trait. Beware of types pointing into themselves, e.g. the
+// std::string of libstdc++ with its small string optimization
+template <class _T>
+struct static_any_trivially_relocatable :
+	public std::integral_constant<bool, detail::static_any::is_trivial_operation<_T>::value>
+{};
+
+// Types compared with their operator== by the operator== of static_any; detected by default, including the elements of
+// the standard containers, std::pair and std::tuple. A type whose operator== is declared but does not compile for it
+// (e.g. a template comparing members it lacks) has to be declared not comparable by specializing this trait
+template <class _T>
+struct static_any_equality_comparable :
+	public std::integral_constant<bool, detail::static_any::is_equality_comparable<_T>::value>
+{};
+
+// Types ordered with their operator< by the operator< of static_any, as static_any_equality_comparable for operator==
+template <class _T>
+struct static_any_less_comparable :
+	public std::integral_constant<bool, detail::static_any::is_less_comparable<_T>::value>
+{};
+
+template <std::size_t _N, std::size_t _Align = detail::static_any::default_alignment(_N)>
 class static_any
 {
 public:
 	template <typename _T>
 	struct is_static_any : public std::false_type {};
 
-	template <std::size_t _M>
-	struct is_static_any<static_any<_M>> : public std::true_type {};
+	template <std::size_t _M, std::size_t _MAlign>
+	struct is_static_any<static_any<_M, _MAlign>> : public std::true_type {};
 
 	template <class _T>
 	static constexpr bool is_static_any_v = is_static_any<_T>::value;
@@ -45,11 +323,16 @@ public:
 
 	static_any(const static_any&);
 
-	template <std::size_t _M, class = std::enable_if_t<_M <= _N>>
-	static_any(const static_any<_M>&);
+	// noexcept so that containers, e.g. std::vector, move the anys instead of copying them: if the move constructor of
+	// the stored value throws, std::terminate is called. Trivially relocatable values are moved as bytes, leaving the
+	// source empty
+	static_any(static_any&&) noexcept;
 
-	template <std::size_t _M, class = std::enable_if_t<_M <= _N>>
-	static_any(static_any<_M>&&);
+	template <std::size_t _M, std::size_t _MAlign, class = std::enable_if_t<_M <= _N && _MAlign <= _Align>>
+	static_any(const static_any<_M, _MAlign>&);
+
+	template <std::size_t _M, std::size_t _MAlign, class = std::enable_if_t<_M <= _N && _MAlign <= _Align>>
+	static_any(static_any<_M, _MAlign>&&);
 
 	template <class _T,
 			  class = std::enable_if_t<!is_static_any_v<std::decay_t<_T>>>>
@@ -61,15 +344,15 @@ public:
 		return *this;
 	}
 
-	template <std::size_t _M, class = std::enable_if_t<_M <= _N>>
-	static_any& operator=(const static_any<_M>& any)
+	template <std::size_t _M, std::size_t _MAlign, class = std::enable_if_t<_M <= _N && _MAlign <= _Align>>
+	static_any& operator=(const static_any<_M, _MAlign>& any)
 	{
 		assign_from_any(any);
 		return *this;
 	}
 
-	template <std::size_t _M, class = std::enable_if_t<_M <= _N>>
-	static_any& operator=(static_any<_M>&& any)
+	template <std::size_t _M, std::size_t _MAlign, class = std::enable_if_t<_M <= _N && _MAlign <= _Align>>
+	static_any& operator=(static_any<_M, _MAlign>&& any)
 	{
 		assign_from_any(std::move(any));
 		return *this;
@@ -83,6 +366,20 @@ public:
 	template <class _T>
 	_T& get();
 
+	// nullptr if the stored value is not a _T
+	template <class _T>
+	const _T* try_get() const noexcept;
+
+	template <class _T>
+	_T* try_get() noexcept;
+
+	// the stored value has to be a _T, which is only asserted
+	template <class _T>
+	const _T& unchecked_get() const noexcept;
+
+	template <class _T>
+	_T& unchecked_get() noexcept;
+
 	template <class _T>
 	bool has() const;
 
@@ -94,12 +391,20 @@ public:
 
 	static constexpr size_type capacity();
 
+	static constexpr size_type alignment();
+
 	template <class _T, class... Args>
 	void emplace(Args&&... args);
 
+	// Exchanges the values through a single scratch buffer, or as raw bytes for trivially relocatable values (see
+	// static_any_trivially_relocatable), without the backups of the assignments. Each value must fit in the other any,
+	// std::length_error is thrown otherwise. Does not throw if both types are nothrow move constructible; if a move
+	// throws, values may be lost but the anys stay valid
+	template <std::size_t _M, std::size_t _MAlign>
+	void swap(static_any<_M, _MAlign>& other);
+
 private:
-	using operation_t = detail::static_any::operation_t;
-	using function_ptr_t = detail::static_any::function_ptr_t;
+	using function_table_ptr_t = detail::static_any::function_table_ptr_t;
 
 	template <class _T>
 	void copy_or_move(_T&& t);
@@ -107,8 +412,15 @@ private:
 	template <class _T>
 	void assign_from_any(_T&&);
 
-	template <std::size_t _M, class CopyOrMoveTag>
-	void assign_from_any(const static_any<_M>&, CopyOrMoveTag);
+	template <std::size_t _M, std::size_t _MAlign, class CopyOrMoveTag>
+	void assign_from_any(const static_any<_M, _MAlign>&, CopyOrMoveTag);
+
+	void backup_to(static_any& temp);
+
+	static bool fits(function_table_ptr_t function);
+
+	// moves the value of type function from other_ptr to this_ptr, and destroys it there
+	static void move_and_destroy(function_table_ptr_t function, void* this_ptr, void* other_ptr);
 
 	const std::type_info& query_type() const;
 
@@ -125,125 +437,402 @@ private:
 	template <class _RefT>
 	void call_copy_or_move(void* this_void_ptr, void* other_void_ptr);
 
-	void call_operation(const function_ptr_t& function, void* this_void_ptr, void* other_void_ptr, detail::static_any::move_tag);
+	template <std::size_t _M, class CopyOrMoveTag>
+	void call_operation(function_table_ptr_t function, void* this_void_ptr, void* other_void_ptr, CopyOrMoveTag);
+
+	static void call_function(function_table_ptr_t function, void* this_void_ptr, void* other_void_ptr, detail::static_any::move_tag);
+
+	static void call_function(function_table_ptr_t function, void* this_void_ptr, void* other_void_ptr, detail::static_any::copy_tag);
 
-	void call_operation(const function_ptr_t& function, void* this_void_ptr, void* other_void_ptr, detail::static_any::copy_tag);
+	static bool is_nothrow_operation(function_table_ptr_t function, detail::static_any::move_tag);
+
+	static bool is_nothrow_operation(function_table_ptr_t function, detail::static_any::copy_tag);
 
 	template <class _T>
 	void copy_or_move_from_another(_T&&);
 
-	std::array<char, _N> __buff;
-	function_ptr_t __function{};
+	// moves the value of another with a memcpy and empties another if it is trivially relocatable, but not trivial
+	// (whose source is left as is): returns false otherwise
+	template <std::size_t _M, std::size_t _MAlign>
+	bool relocate_from(const static_any<_M, _MAlign>& another, detail::static_any::move_tag);
+
+	template <std::size_t _M, std::size_t _MAlign>
+	bool relocate_from(const static_any<_M, _MAlign>&, detail::static_any::copy_tag) { return false; }
 
-	template <std::size_t _S>
+	alignas(_Align) std::array<char, _N> __buff;
+	function_table_ptr_t __function{};
+
+	template <std::size_t _S, std::size_t _A>
 	friend class static_any;
 
-	template <class _ValueT, std::size_t _S>
-	friend _ValueT* any_cast(static_any<_S>*);
+	friend struct detail::static_any::any_access;
+
+	template <class _ValueT, std::size_t _S, std::size_t _A>
+	friend _ValueT* any_cast(static_any<_S, _A>*);
+
+	template <class _ValueT, std::size_t _S, std::size_t _A>
+	friend _ValueT& any_cast(static_any<_S, _A>&);
+};
+
+class bad_any_copy : public std::logic_error
+{
+public:
+	explicit bad_any_copy(const std::type_info& type) :
+		std::logic_error(std::string("failed copy of static_any: stored type ") + type.name() + " is not copy constructible"),
+		__type(type)
+	{}
+
+	const std::type_info& stored_type() const { return __type; }
+
+private:
+	const std::type_info& __type;
+};
+
+class bad_any_comparison : public std::logic_error
+{
+public:
+	// op is the missing operator, "==" or "<"
+	explicit bad_any_comparison(const std::type_info& type, const char* op = "==") :
+		std::logic_error(std::string("failed comparison of static_any: stored type ") + type.name() + " has no operator" + op),
+		__type(type)
+	{}
+
+	const std::type_info& stored_type() const { return __type; }
+
+private:
+	const std::type_info& __type;
+};
+
+class bad_any_hash : public std::logic_error
+{
+public:
+	explicit bad_any_hash(const std::type_info& type) :
+		std::logic_error(std::string("failed hash of static_any: stored type ") + type.name() + " is not supported by std::hash"),
+		__type(type)
+	{}
+
+	const std::type_info& stored_type() const { return __type; }
+
+private:
+	const std::type_info& __type;
+};
+
+// a hybrid_static_any cannot allocate a value more aligned than std::max_align_t: it can only store it inline
+class bad_any_alignment : public std::logic_error
+{
+public:
+	explicit bad_any_alignment(const std::type_info& type) :
+		std::logic_error(std::string("failed allocation of hybrid_static_any: stored type ") + type.name() + " is more aligned than std::max_align_t"),
+		__type(type)
+	{}
 
-	template <class _ValueT, std::size_t _S>
-	friend _ValueT& any_cast(static_any<_S>&);
+	const std::type_info& stored_type() const { return __type; }
+
+private:
+	const std::type_info& __type;
 };
 
 namespace detail { namespace static_any {
 
-template <class _T>
-static void operation(operation_t operation, void* ptr1, void* ptr2)
+template <class _T, bool = std::is_copy_constructible<_T>::value>
+struct copy_function_for
 {
-	_T* this_ptr = reinterpret_cast<_T*>(ptr1);
+	static void copy(void* this_ptr, const void* other_ptr)
+	{
+		assert(this_ptr);
+		assert(other_ptr);
+		new(this_ptr)_T(*reinterpret_cast<const _T*>(other_ptr));
+	}
+};
 
-	switch(operation)
+// move only types: copying a static_any storing them can only be detected at runtime
+template <class _T>
+struct copy_function_for<_T, false>
+{
+	[[noreturn]] static void copy(void*, const void*)
 	{
-	case operation_t::query_type:
+		throw bad_any_copy(typeid(_T));
+	}
+};
+
+template <class _T, bool = ::static_any_equality_comparable<_T>::value>
+struct equal_function_for
+{
+	static bool equal(const void* this_ptr, const void* other_ptr)
 	{
-		*reinterpret_cast<const std::type_info**>(ptr1) = &typeid(_T);
-		break;
+		return *reinterpret_cast<const _T*>(this_ptr) == *reinterpret_cast<const _T*>(other_ptr);
 	}
-	case operation_t::query_size:
+
+	static constexpr bool (*value)(const void*, const void*) = &equal;
+};
+
+template <class _T>
+struct equal_function_for<_T, false>
+{
+	static constexpr bool (*value)(const void*, const void*) = nullptr;
+};
+
+template <class _T, bool = ::static_any_less_comparable<_T>::value>
+struct less_function_for
+{
+	static bool less(const void* this_ptr, const void* other_ptr)
 	{
-		*reinterpret_cast<std::size_t*>(ptr1) = sizeof(_T);
-		break;
+		return *reinterpret_cast<const _T*>(this_ptr) < *reinterpret_cast<const _T*>(other_ptr);
 	}
-	case operation_t::copy:
+
+	static constexpr bool (*value)(const void*, const void*) = &less;
+};
+
+template <class _T>
+struct less_function_for<_T, false>
+{
+	static constexpr bool (*value)(const void*, const void*) = nullptr;
+};
+
+template <class _T, bool = is_hashable<_T>::value>
+struct hash_function_for
+{
+	static std::size_t hash(const void* this_ptr)
 	{
-		_T* other_ptr = reinterpret_cast<_T*>(ptr2);
-		assert(this_ptr);
-		assert(other_ptr);
-		new(this_ptr)_T(*other_ptr);
-		break;
+		return std::hash<_T>()(*reinterpret_cast<const _T*>(this_ptr));
 	}
-	case operation_t::move:
+
+	static constexpr std::size_t (*value)(const void*) = &hash;
+};
+
+template <class _T>
+struct hash_function_for<_T, false>
+{
+	static constexpr std::size_t (*value)(const void*) = nullptr;
+};
+
+template <class _T>
+struct function_table_for
+{
+	static void move(void* this_ptr, void* other_ptr)
 	{
-		_T* other_ptr = reinterpret_cast<_T*>(ptr2);
 		assert(this_ptr);
 		assert(other_ptr);
-		new(this_ptr)_T(std::move(*other_ptr));
-		break;
+		new(this_ptr)_T(std::move(*reinterpret_cast<_T*>(other_ptr)));
 	}
-	case operation_t::destroy:
+
+	static void destroy(void* this_ptr)
 	{
 		assert(this_ptr);
-		this_ptr->~_T();
-		break;
+		reinterpret_cast<_T*>(this_ptr)->~_T();
 	}
+
+	static void relocate(void* this_ptr, void* other_ptr)
+	{
+		move(this_ptr, other_ptr);
+		destroy(other_ptr);
 	}
+
+	static constexpr function_table_t value =
+	{
+		&copy_function_for<_T>::copy,
+		&move,
+		&destroy,
+		&relocate,
+		equal_function_for<_T>::value,
+		less_function_for<_T>::value,
+		hash_function_for<_T>::value,
+		&typeid(_T),
+		type_hash_v<_T>,
+		sizeof(_T),
+		alignof(_T),
+		is_trivial_operation<_T>::value,
+		is_trivial_operation<_T>::value || ::static_any_trivially_relocatable<_T>::value,
+		std::is_copy_constructible<_T>::value,
+		std::is_nothrow_copy_constructible<_T>::value,
+		std::is_nothrow_move_constructible<_T>::value
+#if defined(STATIC_ANY_INSTRUMENTATION)
+		, &counters_for<_T>::value
+#endif
+	};
+};
+
+template <class _T>
+constexpr function_table_t function_table_for<_T>::value;
+
+template <class _T>
+constexpr function_table_ptr_t get_function_for_type()
+{
+	return &function_table_for<std::remove_cv_t<std::remove_reference_t<_T>>>::value;
 }
 
 template <class _T>
-static function_ptr_t get_function_for_type()
+inline bool is_function_for_type(function_table_ptr_t function)
+{
+	assert(function != nullptr);
+
+	if (function == get_function_for_type<_T>())
+		return true;
+
+	// the function tables differ across DLL boundaries, but the type hashes don't
+	if (function->type_hash != type_hash_v<_T>)
+		return false;
+
+	count(function, counter::slow_type_check);
+	return *function->type == typeid(std::remove_cv_t<std::remove_reference_t<_T>>);
+}
+
+// true if both tables are the ones of the same type, possibly coming from different modules
+inline bool is_same_type(function_table_ptr_t function, function_table_ptr_t other_function)
 {
-	return &static_any::operation<std::remove_cv_t<std::remove_reference_t<_T>>>;
+	assert(function != nullptr);
+	assert(other_function != nullptr);
+
+	return function == other_function ||
+		(function->type_hash == other_function->type_hash && *function->type == *other_function->type);
 }
 
+// Process-wide registry mapping compact type indexes to function tables. A type gets its index lazily,
+// the first time it is requested; 0 is reserved for "no type". The indexes depend on the order of
+// registration, so they are not stable across processes, nor across modules that don't share the
+// registry (e.g. DLLs on Windows).
+template <class _IndexT>
+class type_registry
+{
+public:
+	static_assert(std::is_unsigned<_IndexT>::value && sizeof(_IndexT) <= 2, "type index must be an unsigned integer of 1 or 2 bytes");
+
+	using index_type = _IndexT;
+
+	static constexpr index_type empty_index = 0;
+	static constexpr std::size_t max_size = std::numeric_limits<index_type>::max();
+
+	template <class _T>
+	static index_type index()
+	{
+		return index_of<std::remove_cv_t<std::remove_reference_t<_T>>>();
+	}
+
+	// index of _T if it has already been registered, empty_index otherwise: a type that has never been
+	// registered cannot have been stored, there is no need to register it only to compare it
+	template <class _T>
+	static index_type find()
+	{
+		return registered_index<std::remove_cv_t<std::remove_reference_t<_T>>>::value.load(std::memory_order_acquire);
+	}
+
+	static function_table_ptr_t function(index_type idx)
+	{
+		return __functions[idx].load(std::memory_order_acquire);
+	}
+
+private:
+	template <class _T>
+	struct registered_index
+	{
+		static std::atomic<index_type> value;
+	};
+
+	template <class _T>
+	static index_type index_of()
+	{
+		static const index_type idx = register_type<_T>();
+		return idx;
+	}
+
+	template <class _T>
+	static index_type register_type()
+	{
+		const std::size_t idx = __size.fetch_add(1, std::memory_order_relaxed) + 1;
+		if (idx > max_size)
+			throw std::overflow_error("too many types registered in static_any type registry");
+
+		__functions[idx].store(get_function_for_type<_T>(), std::memory_order_release);
+		registered_index<_T>::value.store(static_cast<index_type>(idx), std::memory_order_release);
+		return static_cast<index_type>(idx);
+	}
+
+	static std::atomic<std::size_t> __size;
+	static std::array<std::atomic<function_table_ptr_t>, max_size + 1> __functions;
+};
+
+template <class _IndexT>
+template <class _T>
+std::atomic<_IndexT> type_registry<_IndexT>::registered_index<_T>::value{0};
+
+template <class _IndexT>
+constexpr _IndexT type_registry<_IndexT>::empty_index;
+
+template <class _IndexT>
+std::atomic<std::size_t> type_registry<_IndexT>::__size{0};
+
+template <class _IndexT>
+std::array<std::atomic<function_table_ptr_t>, type_registry<_IndexT>::max_size + 1> type_registry<_IndexT>::__functions{};
+
 }}
 
-template <std::size_t _N>
-static_any<_N>::static_any()
+template <std::size_t _N, std::size_t _Align>
+static_any<_N, _Align>::static_any()
 {}
 
-template <std::size_t _N>
-static_any<_N>::~static_any()
+template <std::size_t _N, std::size_t _Align>
+static_any<_N, _Align>::~static_any()
 {
 	destroy();
 }
 
-template <std::size_t _N>
+template <std::size_t _N, std::size_t _Align>
 template <class _T, class>
-static_any<_N>::static_any(_T&& v)
+static_any<_N, _Align>::static_any(_T&& v)
 {
 	copy_or_move(std::forward<_T>(v));
 }
 
-template <std::size_t _N>
-static_any<_N>::static_any(const static_any<_N>& another)
+template <std::size_t _N, std::size_t _Align>
+static_any<_N, _Align>::static_any(const static_any<_N, _Align>& another)
 {
 	copy_or_move_from_another(another);
 }
 
-template <std::size_t _N>
-template <std::size_t _M, class>
-static_any<_N>::static_any(const static_any<_M>& another)
+template <std::size_t _N, std::size_t _Align>
+static_any<_N, _Align>::static_any(static_any<_N, _Align>&& another) noexcept
+{
+	copy_or_move_from_another(std::move(another));
+}
+
+template <std::size_t _N, std::size_t _Align>
+template <std::size_t _M, std::size_t _MAlign, class>
+static_any<_N, _Align>::static_any(const static_any<_M, _MAlign>& another)
 {
 	copy_or_move_from_another(another);
 }
 
-template <std::size_t _N>
-template <std::size_t _M, class>
-static_any<_N>::static_any(static_any<_M>&& another)
+template <std::size_t _N, std::size_t _Align>
+template <std::size_t _M, std::size_t _MAlign, class>
+static_any<_N, _Align>::static_any(static_any<_M, _MAlign>&& another)
 {
 	copy_or_move_from_another(std::move(another));
 }
 
-template <std::size_t _N>
+template <std::size_t _N, std::size_t _Align>
 template <class _T, class>
-static_any<_N>& static_any<_N>::operator=(_T&& t)
+static_any<_N, _Align>& static_any<_N, _Align>::operator=(_T&& t)
 {
 	static_assert(capacity() >= sizeof(_T), "_T is too big to be copied to static_any");
+	static_assert(alignment() >= alignof(std::remove_reference_t<_T>), "_T is too aligned to be copied to static_any");
 
 	using NonConstT = std::remove_cv_t<std::remove_reference_t<_T>>;
 	NonConstT* non_const_t = const_cast<NonConstT*>(&t);
 
-	static_any temp = std::move_if_noexcept(*this);
+	static_assert(std::is_constructible<NonConstT, _T&&>::value, "_T is not copy constructible, move only types have to be moved to static_any");
+
+	// no backup needed if the construction cannot throw (known at compile time) or if there is
+	// nothing to restore: either way, *this is left unchanged or empty
+	if (std::is_nothrow_constructible<NonConstT, _T&&>::value || empty())
+	{
+		destroy();
+		call_copy_or_move<_T&&>(__buff.data(), non_const_t);
+		__function = detail::static_any::get_function_for_type<_T>();
+		return *this;
+	}
+
+	static_any temp;
+	backup_to(temp);
 
 	try
 	{
@@ -262,27 +851,18 @@ static_any<_N>& static_any<_N>::operator=(_T&& t)
 	return *this;
 }
 
-template <std::size_t _N>
-void static_any<_N>::reset() { destroy(); }
+template <std::size_t _N, std::size_t _Align>
+void static_any<_N, _Align>::reset() { destroy(); }
 
-template <std::size_t _N>
+template <std::size_t _N, std::size_t _Align>
 template <class _T>
-bool static_any<_N>::has() const
+bool static_any<_N, _Align>::has() const
 {
-	if (__function == detail::static_any::get_function_for_type<_T>())
-	{
-		return true;
-	}
-	else if (__function)
-	{
-		// need to try another, possibly more costly way, as we may compare types across DLL boundaries
-		return std::type_index(typeid(_T)) == std::type_index(query_type());
-	}
-	return false;
+	return __function != nullptr && detail::static_any::is_function_for_type<_T>(__function);
 }
 
-template <std::size_t _N>
-const std::type_info& static_any<_N>::type() const
+template <std::size_t _N, std::size_t _Align>
+const std::type_info& static_any<_N, _Align>::type() const
 {
 	if (empty())
 		return typeid(void);
@@ -290,11 +870,11 @@ const std::type_info& static_any<_N>::type() const
 		return query_type();
 }
 
-template <std::size_t _N>
-bool static_any<_N>::empty() const { return __function == nullptr; }
+template <std::size_t _N, std::size_t _Align>
+bool static_any<_N, _Align>::empty() const { return __function == nullptr; }
 
-template <std::size_t _N>
-typename static_any<_N>::size_type static_any<_N>::size() const
+template <std::size_t _N, std::size_t _Align>
+typename static_any<_N, _Align>::size_type static_any<_N, _Align>::size() const
 {
 	if (empty())
 		return 0;
@@ -302,31 +882,43 @@ typename static_any<_N>::size_type static_any<_N>::size() const
 		return query_size();
 }
 
-template <std::size_t _N>
-constexpr typename static_any<_N>::size_type static_any<_N>::capacity()
+template <std::size_t _N, std::size_t _Align>
+constexpr typename static_any<_N, _Align>::size_type static_any<_N, _Align>::capacity()
 {
 	return _N;
 }
 
-template <std::size_t _N>
+template <std::size_t _N, std::size_t _Align>
+constexpr typename static_any<_N, _Align>::size_type static_any<_N, _Align>::alignment()
+{
+	return _Align;
+}
+
+template <std::size_t _N, std::size_t _Align>
 template <class _T, class... Args>
-void static_any<_N>::emplace(Args&&... args)
+void static_any<_N, _Align>::emplace(Args&&... args)
 {
+	static_assert(capacity() >= sizeof(_T), "_T is too big to be copied to static_any");
+	static_assert(alignment() >= alignof(_T), "_T is too aligned to be copied to static_any");
+
 	destroy();
 	new(__buff.data()) _T(std::forward<Args>(args)...);
 	__function = detail::static_any::get_function_for_type<_T>();
 }
 
-template <std::size_t _N>
+template <std::size_t _N, std::size_t _Align>
 template <class _T>
-void static_any<_N>::copy_or_move(_T&& t)
+void static_any<_N, _Align>::copy_or_move(_T&& t)
 {
 	static_assert(capacity() >= sizeof(_T), "_T is too big to be copied to static_any");
+	static_assert(alignment() >= alignof(std::remove_reference_t<_T>), "_T is too aligned to be copied to static_any");
 	assert(__function == nullptr);
 
 	using NonConstT = std::remove_cv_t<std::remove_reference_t<_T>>;
 	NonConstT* non_const_t = const_cast<NonConstT*>(&t);
 
+	static_assert(std::is_constructible<NonConstT, _T&&>::value, "_T is not copy constructible, move only types have to be moved to static_any");
+
 	try {
 		call_copy_or_move<_T&&>(__buff.data(), non_const_t);
 	}
@@ -337,9 +929,9 @@ void static_any<_N>::copy_or_move(_T&& t)
 	__function = detail::static_any::get_function_for_type<_T>();
 }
 
-template <std::size_t _N>
+template <std::size_t _N, std::size_t _Align>
 template <class _T>
-void static_any<_N>::assign_from_any(_T&& t)
+void static_any<_N, _Align>::assign_from_any(_T&& t)
 {
 	using CopyOrMoveTag = typename std::conditional<
 		std::is_rvalue_reference<_T&&>::value,
@@ -350,21 +942,39 @@ void static_any<_N>::assign_from_any(_T&& t)
 	assign_from_any(std::forward<_T>(t), CopyOrMoveTag{});
 }
 
-template <std::size_t _N>
-template <std::size_t _M, class CopyOrMoveTag>
-void static_any<_N>::assign_from_any(const static_any<_M>& another, CopyOrMoveTag)
+template <std::size_t _N, std::size_t _Align>
+template <std::size_t _M, std::size_t _MAlign, class CopyOrMoveTag>
+void static_any<_N, _Align>::assign_from_any(const static_any<_M, _MAlign>& another, CopyOrMoveTag)
 {
+	if (static_cast<const void*>(&another) == static_cast<const void*>(this))
+		return;
+
 	if (another.__function == nullptr)
+	{
+		destroy();
 		return;
+	}
 
-	static_any temp = std::move_if_noexcept(*this);
 	void* other_data = reinterpret_cast<void*>(const_cast<char*>(another.__buff.data()));
 
+	if (is_nothrow_operation(another.__function, CopyOrMoveTag{}) || empty())
+	{
+		destroy();
+		if (relocate_from(another, CopyOrMoveTag{}))
+			return;
+		call_operation<_M>(another.__function, __buff.data(), other_data, CopyOrMoveTag{});
+		__function = another.__function;
+		return;
+	}
+
+	static_any temp;
+	backup_to(temp);
+
 	try {
 		destroy();
 		assert(__function == nullptr);
 
-		call_operation(another.__function, __buff.data(), other_data, CopyOrMoveTag{});
+		call_operation<_M>(another.__function, __buff.data(), other_data, CopyOrMoveTag{});
 	}
 	catch(...) {
 		*this = std::move(temp);
@@ -374,76 +984,209 @@ void static_any<_N>::assign_from_any(const static_any<_M>& another, CopyOrMoveTa
 	__function= another.__function;
 }
 
-template <std::size_t _N>
-const std::type_info& static_any<_N>::query_type() const
+template <std::size_t _N, std::size_t _Align>
+void static_any<_N, _Align>::backup_to(static_any& temp)
+{
+	assert(__function != nullptr);
+	detail::static_any::count(__function, detail::static_any::counter::backup);
+
+	// the backup is only used to restore *this, so a move is enough when it cannot throw -- and
+	// the only option for move only types
+	if (__function->nothrow_move || !__function->copyable)
+		temp.copy_or_move_from_another(std::move(*this));
+	else
+		temp.copy_or_move_from_another(*this);
+}
+
+template <std::size_t _N, std::size_t _Align>
+template <std::size_t _M, std::size_t _MAlign>
+void static_any<_N, _Align>::swap(static_any<_M, _MAlign>& other)
+{
+	if (static_cast<const void*>(&other) == static_cast<const void*>(this))
+		return;
+
+	const function_table_ptr_t function = __function;
+	const function_table_ptr_t other_function = other.__function;
+
+	if (!fits(other_function) || !other.fits(function))
+		throw std::length_error("static_any::swap: value too big or too aligned for the other static_any");
+
+	// the value of *this is kept in temp while the one of other is moved to *this
+	alignas(_Align) std::array<char, _N> temp;
+
+	if ((function == nullptr || function->relocatable) && (other_function == nullptr || other_function->relocatable))
+	{
+		constexpr std::size_t min_capacity = _M < _N ? _M : _N;
+
+		if (function != nullptr)
+			detail::static_any::trivial_copy<_N>(temp.data(), __buff.data(), function->size);
+		if (other_function != nullptr)
+			detail::static_any::trivial_copy<min_capacity>(__buff.data(), other.__buff.data(), other_function->size);
+		if (function != nullptr)
+			detail::static_any::trivial_copy<min_capacity>(other.__buff.data(), temp.data(), function->size);
+
+		__function = other_function;
+		other.__function = function;
+		return;
+	}
+
+	// a single move if one of them is empty
+	if (other_function == nullptr)
+	{
+		detail::static_any::count(function, detail::static_any::move_tag{});
+		move_and_destroy(function, other.__buff.data(), __buff.data());
+		other.__function = function;
+		__function = nullptr;
+		return;
+	}
+
+	if (function == nullptr)
+	{
+		detail::static_any::count(other_function, detail::static_any::move_tag{});
+		move_and_destroy(other_function, __buff.data(), other.__buff.data());
+		__function = other_function;
+		other.__function = nullptr;
+		return;
+	}
+
+	detail::static_any::count(function, detail::static_any::move_tag{});
+	move_and_destroy(function, temp.data(), __buff.data());
+	__function = nullptr;
+
+	detail::static_any::count(other_function, detail::static_any::move_tag{});
+	try {
+		move_and_destroy(other_function, __buff.data(), other.__buff.data());
+	}
+	catch(...) {
+		// other is unchanged: the value of *this is put back, or lost if it cannot be
+		try {
+			move_and_destroy(function, __buff.data(), temp.data());
+			__function = function;
+		}
+		catch(...) {
+			function->destroy(temp.data());
+		}
+		throw;
+	}
+	__function = other_function;
+	other.__function = nullptr;
+
+	detail::static_any::count(function, detail::static_any::move_tag{});
+	try {
+		move_and_destroy(function, other.__buff.data(), temp.data());
+	}
+	catch(...) {
+		function->destroy(temp.data());
+		throw;
+	}
+	other.__function = function;
+}
+
+template <std::size_t _N, std::size_t _Align>
+bool static_any<_N, _Align>::fits(function_table_ptr_t function)
+{
+	return function == nullptr || (function->size <= _N && function->alignment <= _Align);
+}
+
+template <std::size_t _N, std::size_t _Align>
+void static_any<_N, _Align>::move_and_destroy(function_table_ptr_t function, void* this_ptr, void* other_ptr)
+{
+	if (function->relocatable)
+		std::memcpy(this_ptr, other_ptr, function->size);
+	else
+		function->relocate(this_ptr, other_ptr);
+}
+
+template <std::size_t _N, std::size_t _Align>
+const std::type_info& static_any<_N, _Align>::query_type() const
 {
 	assert(__function != nullptr);
-	const std::type_info* ti ;
-	__function(operation_t::query_type, &ti, nullptr);
-	return *ti;
+	return *__function->type;
 }
 
-template <std::size_t _N>
-typename static_any<_N>::size_type static_any<_N>::query_size() const
+template <std::size_t _N, std::size_t _Align>
+typename static_any<_N, _Align>::size_type static_any<_N, _Align>::query_size() const
 {
 	assert(__function != nullptr);
-	std::size_t size;
-	__function(operation_t::query_size, &size, nullptr);
-	return size;
+	return __function->size;
 }
 
-template <std::size_t _N>
-void static_any<_N>::destroy()
+template <std::size_t _N, std::size_t _Align>
+void static_any<_N, _Align>::destroy()
 {
 	if (__function)
 	{
-		void* not_used = nullptr;
-		__function(operation_t::destroy, __buff.data(), not_used);
+		if (!__function->trivial)
+			__function->destroy(__buff.data());
 		__function = nullptr;
 	}
 }
 
-template <std::size_t _N>
+template <std::size_t _N, std::size_t _Align>
 template <class _T>
-const _T* static_any<_N>::as() const
+const _T* static_any<_N, _Align>::as() const
 {
 	return reinterpret_cast<const _T*>(__buff.data());
 }
 
-template <std::size_t _N>
+template <std::size_t _N, std::size_t _Align>
 template <class _T>
-_T* static_any<_N>::as()
+_T* static_any<_N, _Align>::as()
 {
 	return reinterpret_cast<_T*>(__buff.data());
 }
 
-template <std::size_t _N>
+template <std::size_t _N, std::size_t _Align>
 template <class _RefT>
-void static_any<_N>::call_copy_or_move(void* this_void_ptr, void* other_void_ptr)
+void static_any<_N, _Align>::call_copy_or_move(void* this_void_ptr, void* other_void_ptr)
 {
-	using Tag = typename std::conditional<std::is_rvalue_reference<_RefT&&>::value,
-				detail::static_any::move_tag,
-				detail::static_any::copy_tag>::type;
+	using NonConstT = std::remove_cv_t<std::remove_reference_t<_RefT>>;
+
+	// the type is known at compile time, no need to go through the function table
+	new(this_void_ptr) NonConstT(std::forward<_RefT>(*reinterpret_cast<NonConstT*>(other_void_ptr)));
+}
+
+template <std::size_t _N, std::size_t _Align>
+template <std::size_t _M, class CopyOrMoveTag>
+void static_any<_N, _Align>::call_operation(function_table_ptr_t function, void* this_void_ptr, void* other_void_ptr, CopyOrMoveTag)
+{
+	static_assert(_M <= _N, "source buffer is bigger than static_any");
+
+	detail::static_any::count(function, CopyOrMoveTag{});
+
+	if (function->trivial)
+		detail::static_any::trivial_copy<_M>(this_void_ptr, other_void_ptr, function->size);
+	else
+		call_function(function, this_void_ptr, other_void_ptr, CopyOrMoveTag{});
+}
+
+template <std::size_t _N, std::size_t _Align>
+void static_any<_N, _Align>::call_function(function_table_ptr_t function, void* this_void_ptr, void* other_void_ptr, detail::static_any::move_tag)
+{
+	function->move(this_void_ptr, other_void_ptr);
+}
 
-	auto function = detail::static_any::get_function_for_type<_RefT>();
-	call_operation(function, this_void_ptr, other_void_ptr, Tag{});
+template <std::size_t _N, std::size_t _Align>
+void static_any<_N, _Align>::call_function(function_table_ptr_t function, void* this_void_ptr, void* other_void_ptr, detail::static_any::copy_tag)
+{
+	function->copy(this_void_ptr, other_void_ptr);
 }
 
-template <std::size_t _N>
-void static_any<_N>::call_operation(const function_ptr_t& function, void* this_void_ptr, void* other_void_ptr, detail::static_any::move_tag)
+template <std::size_t _N, std::size_t _Align>
+bool static_any<_N, _Align>::is_nothrow_operation(function_table_ptr_t function, detail::static_any::move_tag)
 {
-	function(operation_t::move, this_void_ptr, other_void_ptr);
+	return function->nothrow_move || function->relocatable;
 }
 
-template <std::size_t _N>
-void static_any<_N>::call_operation(const function_ptr_t& function, void* this_void_ptr, void* other_void_ptr, detail::static_any::copy_tag)
+template <std::size_t _N, std::size_t _Align>
+bool static_any<_N, _Align>::is_nothrow_operation(function_table_ptr_t function, detail::static_any::copy_tag)
 {
-	function(operation_t::copy, this_void_ptr, other_void_ptr);
+	return function->nothrow_copy;
 }
 
-template <std::size_t _N>
+template <std::size_t _N, std::size_t _Align>
 template <class _T>
-void static_any<_N>::copy_or_move_from_another(_T&& another)
+void static_any<_N, _Align>::copy_or_move_from_another(_T&& another)
 {
 	assert(__function == nullptr);
 
@@ -456,10 +1199,13 @@ void static_any<_N>::copy_or_move_from_another(_T&& another)
 				detail::static_any::move_tag,
 				detail::static_any::copy_tag>::type;
 
+	if (relocate_from(another, Tag{}))
+		return;
+
 	void* other_data = reinterpret_cast<void*>(const_cast<char*>(another.__buff.data()));
 
 	try {
-		call_operation(another.__function, __buff.data(), other_data, Tag{});
+		call_operation<std::decay_t<_T>::capacity()>(another.__function, __buff.data(), other_data, Tag{});
 	}
 	catch(...) {
 		throw;
@@ -468,6 +1214,24 @@ void static_any<_N>::copy_or_move_from_another(_T&& another)
 	__function= another.__function;
 }
 
+template <std::size_t _N, std::size_t _Align>
+template <std::size_t _M, std::size_t _MAlign>
+bool static_any<_N, _Align>::relocate_from(const static_any<_M, _MAlign>& another, detail::static_any::move_tag)
+{
+	const function_table_ptr_t function = another.__function;
+	assert(function != nullptr && __function == nullptr);
+
+	if (function->trivial || !function->relocatable)
+		return false;
+
+	detail::static_any::count(function, detail::static_any::move_tag{});
+	detail::static_any::trivial_copy<_M>(__buff.data(), another.__buff.data(), function->size);
+
+	__function = function;
+	const_cast<static_any<_M, _MAlign>&>(another).__function = nullptr;
+	return true;
+}
+
 class bad_any_cast : public std::bad_cast
 {
 public:
@@ -478,35 +1242,51 @@ public:
 	const std::type_info& stored_type() const { return __from; }
 	const std::type_info& target_type() const { return __to; }
 
-	const char* what() const noexcept override
-	{
-		return __reason.c_str();
-	}
+	// formatted in a fixed buffer at construction, truncated if too long: throwing a bad_any_cast does not allocate,
+	// and what() is safe to call from several threads
+	const char* what() const noexcept override;
 
 private:
+	static constexpr std::size_t reason_size = 256;
+
+	// appends s to __reason from position, returns the new position
+	std::size_t append(std::size_t position, const char* s) noexcept;
+
 	const std::type_info& __from;
 	const std::type_info& __to;
-	std::string __reason;
+	std::array<char, reason_size> __reason;
 };
 
-bad_any_cast::bad_any_cast(const std::type_info& from,
+inline bad_any_cast::bad_any_cast(const std::type_info& from,
 						   const std::type_info& to) :
 	__from(from),
 	__to(to)
 {
-	std::ostringstream oss;
-	oss << "failed conversion using any_cast: stored type "
-		<< from.name()
-		<< ", trying to cast to "
-		<< to.name();
-	__reason = oss.str();
+	std::size_t position = append(0, "failed conversion using any_cast: stored type ");
+	position = append(position, __from.name());
+	position = append(position, ", trying to cast to ");
+	position = append(position, __to.name());
+	__reason[position] = '\0';
+}
+
+inline std::size_t bad_any_cast::append(std::size_t position, const char* s) noexcept
+{
+	for (; *s != '\0' && position < reason_size - 1; ++s, ++position)
+		__reason[position] = *s;
+	return position;
 }
 
-bad_any_cast::~bad_any_cast() {}
+inline const char* bad_any_cast::what() const noexcept
+{
+	return __reason.data();
+}
+
+inline bad_any_cast::~bad_any_cast() {}
 
 template <class _ValueT,
-		  std::size_t _S>
-inline _ValueT* any_cast(static_any<_S>* a)
+		  std::size_t _S,
+		  std::size_t _A>
+inline _ValueT* any_cast(static_any<_S, _A>* a)
 {
 	if (!a->template has<_ValueT>())
 		return nullptr;
@@ -515,90 +1295,1627 @@ inline _ValueT* any_cast(static_any<_S>* a)
 }
 
 template <class _ValueT,
-		  std::size_t _S>
-inline const _ValueT* any_cast(const static_any<_S>* a)
+		  std::size_t _S,
+		  std::size_t _A>
+inline const _ValueT* any_cast(const static_any<_S, _A>* a)
 {
-	return any_cast<const _ValueT>(const_cast<static_any<_S>*>(a));
+	return any_cast<const _ValueT>(const_cast<static_any<_S, _A>*>(a));
 }
 
 template <class _ValueT,
-		  std::size_t _S>
-inline _ValueT& any_cast(static_any<_S>& a)
+		  std::size_t _S,
+		  std::size_t _A>
+inline _ValueT& any_cast(static_any<_S, _A>& a)
 {
 	if (!a.template has<_ValueT>())
+	{
+		detail::static_any::count(a.__function, detail::static_any::counter::bad_cast);
 		throw bad_any_cast(a.type(), typeid(_ValueT));
+	}
 
 	return *a.template as<_ValueT>();
 }
 
 template <class _ValueT,
-		  std::size_t _S>
-inline const _ValueT& any_cast(const static_any<_S>& a)
+		  std::size_t _S,
+		  std::size_t _A>
+inline const _ValueT& any_cast(const static_any<_S, _A>& a)
 {
-	return any_cast<const _ValueT>(const_cast<static_any<_S>&>(a));
+	return any_cast<const _ValueT>(const_cast<static_any<_S, _A>&>(a));
 }
 
-template <std::size_t _S>
+template <std::size_t _S, std::size_t _A>
 template <class _T>
-const _T& static_any<_S>::get() const
+const _T& static_any<_S, _A>::get() const
 {
 	return any_cast<_T>(*this);
 }
 
-template <std::size_t _S>
+template <std::size_t _S, std::size_t _A>
 template <class _T>
-_T& static_any<_S>::get()
+_T& static_any<_S, _A>::get()
 {
 	return any_cast<_T>(*this);
 }
 
+template <std::size_t _S, std::size_t _A>
+template <class _T>
+const _T* static_any<_S, _A>::try_get() const noexcept
+{
+	return any_cast<_T>(this);
+}
 
-template <std::size_t _N>
-class static_any_t
+template <std::size_t _S, std::size_t _A>
+template <class _T>
+_T* static_any<_S, _A>::try_get() noexcept
 {
-public:
-	using size_type = std::size_t;
+	return any_cast<_T>(this);
+}
 
-	static constexpr size_type capacity() { return _N; }
+template <std::size_t _S, std::size_t _A>
+template <class _T>
+const _T& static_any<_S, _A>::unchecked_get() const noexcept
+{
+	assert(has<_T>());
+	return *as<_T>();
+}
 
-	static_any_t() = default;
-	static_any_t(const static_any_t&) = default;
+template <std::size_t _S, std::size_t _A>
+template <class _T>
+_T& static_any<_S, _A>::unchecked_get() noexcept
+{
+	assert(has<_T>());
+	return *as<_T>();
+}
 
-	template <class _ValueT>
-	static_any_t(_ValueT&& t)
+#if defined(STATIC_ANY_INSTRUMENTATION)
+
+// Events counted by static_any, compact_static_any, hybrid_static_any and checked_static_any_t when
+// STATIC_ANY_INSTRUMENTATION is defined -- in every module using them, as it changes the function tables. The counters
+// are relaxed atomics, for all the types and per type of value, attached to its function table: a snapshot is not
+// consistent across counters updated concurrently.
+struct static_any_counters
+{
+	std::uint64_t copies;           // values copied from an any to another, including backups
+	std::uint64_t moves;            // values moved from an any to another, including backups
+	std::uint64_t slow_type_checks; // types identified by their hash, their function table coming from another module
+	std::uint64_t bad_casts;        // bad_any_cast thrown
+	std::uint64_t backups;          // previous values saved by an assignment whose construction can throw
+};
+
+namespace detail { namespace static_any {
+
+inline static_any_counters snapshot(const counters_t& counters)
+{
+	auto get = [&counters](counter c) { return counters.values[static_cast<std::size_t>(c)].load(std::memory_order_relaxed); };
+	return {get(counter::copy), get(counter::move), get(counter::slow_type_check), get(counter::bad_cast), get(counter::backup)};
+}
+
+inline void reset(counters_t& counters)
+{
+	for (std::atomic<std::uint64_t>& value : counters.values)
+		value.store(0, std::memory_order_relaxed);
+}
+
+}}
+
+// counters of all the types
+inline static_any_counters snapshot_static_any_counters()
+{
+	return detail::static_any::snapshot(detail::static_any::counters_for<void>::value);
+}
+
+// counters of the values of type _T
+template <class _T>
+static_any_counters snapshot_static_any_counters()
+{
+	return detail::static_any::snapshot(*detail::static_any::get_function_for_type<_T>()->counters);
+}
+
+// resets the counters of all the types, but not the ones of each type
+inline void reset_static_any_counters()
+{
+	detail::static_any::reset(detail::static_any::counters_for<void>::value);
+}
+
+template <class _T>
+void reset_static_any_counters()
+{
+	detail::static_any::reset(*detail::static_any::get_function_for_type<_T>()->counters);
+}
+
+#endif
+
+
+namespace detail { namespace static_any {
+
+struct any_access
+{
+	template <std::size_t _N, std::size_t _Align>
+	static function_table_ptr_t function(const ::static_any<_N, _Align>& a) { return a.__function; }
+
+	template <class _T, std::size_t _N, std::size_t _Align>
+	static _T& get(::static_any<_N, _Align>& a) { return *a.template as<_T>(); }
+
+	template <class _T, std::size_t _N, std::size_t _Align>
+	static const _T& get(const ::static_any<_N, _Align>& a) { return *a.template as<_T>(); }
+
+	template <std::size_t _N, std::size_t _Align>
+	static void* data(::static_any<_N, _Align>& a) { return a.__buff.data(); }
+
+	template <std::size_t _N, std::size_t _Align>
+	static const void* data(const ::static_any<_N, _Align>& a) { return a.__buff.data(); }
+};
+
+inline std::size_t combine_hashes(type_hash_t type_hash, std::size_t value_hash)
+{
+	const std::size_t seed = std::hash<type_hash_t>()(type_hash);
+	return seed ^ (value_hash + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+// hash of a value stored in an any: the hash of its type combined with std::hash of the value, 0 if empty
+inline std::size_t hash_value(function_table_ptr_t function, const void* data)
+{
+	if (function == nullptr)
+		return 0;
+	if (function->hash == nullptr)
+		throw bad_any_hash(*function->type);
+	return combine_hashes(function->type_hash, function->hash(data));
+}
+
+// hash of an any storing t
+template <class _T>
+std::size_t hash_value(const _T& t)
+{
+	static_assert(is_hashable<_T>::value, "_T is not supported by std::hash");
+	return combine_hashes(type_hash_v<_T>, std::hash<_T>()(t));
+}
+
+// values of the same type, compared with its operator==
+inline bool equal_values(function_table_ptr_t function, const void* this_ptr, const void* other_ptr)
+{
+	if (function->equal == nullptr)
+		throw bad_any_comparison(*function->type);
+	return function->equal(this_ptr, other_ptr);
+}
+
+// Total order of the values stored in anys: empty first, then by the hash of their type, then with the operator< of the
+// type. The hash of a type is the same in every module built with the same compiler, but not across compilers
+inline bool less_values(function_table_ptr_t function, const void* this_ptr, function_table_ptr_t other_function, const void* other_ptr)
+{
+	if (function == nullptr || other_function == nullptr)
+		return function == nullptr && other_function != nullptr;
+
+	if (!is_same_type(function, other_function))
 	{
-		copy(std::forward<_ValueT>(t));
+		// distinct types whose names hash the same are ordered by their std::type_info
+		if (function->type_hash != other_function->type_hash)
+			return function->type_hash < other_function->type_hash;
+		return function->type->before(*other_function->type);
 	}
 
-	template <class _ValueT>
-	static_any_t& operator=(_ValueT&& t)
+	if (function->less == nullptr)
+		throw bad_any_comparison(*function->type, "<");
+	return function->less(this_ptr, other_ptr);
+}
+
+template <std::size_t _I, class... _Ts>
+using nth_type_t = std::tuple_element_t<_I, std::tuple<_Ts...>>;
+
+constexpr std::size_t int_pow(std::size_t base, std::size_t exp)
+{
+	return exp == 0 ? 1 : base * int_pow(base, exp - 1);
+}
+
+// Perfect hash of the type hashes of _Ts: ((type_hash >> shift) & mask) is unique for each of them, so finding
+// which of _Ts is stored is a single lookup, whatever the number of types
+template <class _T, class... _Ts>
+constexpr bool is_one_of()
+{
+	bool found = false;
+	(void)std::initializer_list<bool>{ (found = found || std::is_same<_T, _Ts>::value)... };
+	return found;
+}
+
+template <class... _Ts>
+struct are_distinct_types : public std::true_type {};
+
+template <class _T, class... _Ts>
+struct are_distinct_types<_T, _Ts...> :
+	public std::integral_constant<bool, !is_one_of<_T, _Ts...>() && are_distinct_types<_Ts...>::value>
+{};
+
+template <std::size_t _K>
+struct perfect_hash_t
+{
+	unsigned shift;
+	type_hash_t mask;
+};
+
+template <std::size_t _K>
+constexpr bool is_perfect_hash(const std::array<type_hash_t, _K>& hashes, unsigned shift, type_hash_t mask)
+{
+	for (std::size_t i = 0; i < _K; ++i)
+		for (std::size_t j = 0; j < i; ++j)
+			if (((hashes[i] >> shift) & mask) == ((hashes[j] >> shift) & mask))
+				return false;
+	return true;
+}
+
+template <std::size_t _K>
+constexpr perfect_hash_t<_K> find_perfect_hash(const std::array<type_hash_t, _K>& hashes)
+{
+	type_hash_t mask = 1;
+	while (mask < _K)
+		mask <<= 1;
+
+	for (; mask <= 64 * _K; mask <<= 1)
+		for (unsigned shift = 0; shift < 64; ++shift)
+			if (is_perfect_hash(hashes, shift, mask - 1))
+				return {shift, mask - 1};
+
+	return {0, 0};
+}
+
+template <class... _Ts>
+struct type_index_map
+{
+	static constexpr std::size_t not_found = sizeof...(_Ts);
+
+	static constexpr std::array<type_hash_t, sizeof...(_Ts)> hashes = {{ type_hash_v<_Ts>... }};
+	static constexpr perfect_hash_t<sizeof...(_Ts)> hash = find_perfect_hash(hashes);
+
+	static_assert(are_distinct_types<_Ts...>::value, "duplicate types");
+
+	// distinct types with the same name, and then the same hash: no perfect hash, the types are searched one by one
+	static constexpr bool colliding = sizeof...(_Ts) > 1 && hash.mask == 0;
+
+	// the function table of the type in this module: the stored type is found with a pointer comparison, the type
+	// hash and std::type_info being compared only for the tables of other modules
+	struct slot_t
 	{
-		copy(std::forward<_ValueT>(t));
-		return *this;
+		type_hash_t hash;
+		function_table_ptr_t function;
+		std::size_t index;
+	};
+
+	struct slots_t
+	{
+		slot_t values[static_cast<std::size_t>(hash.mask) + 1];
+	};
+
+	static constexpr std::size_t slot(type_hash_t h) { return static_cast<std::size_t>((h >> hash.shift) & hash.mask); }
+
+	static constexpr slots_t make_slots()
+	{
+		constexpr function_table_ptr_t functions[] = { get_function_for_type<_Ts>()... };
+
+		slots_t slots{};
+		for (slot_t& s : slots.values)
+			s = {0, nullptr, not_found};
+		for (std::size_t i = 0; i < sizeof...(_Ts); ++i)
+			slots.values[slot(hashes[i])] = {hashes[i], functions[i], i};
+		return slots;
 	}
 
-	template <class _ValueT>
-	_ValueT& get() { return *reinterpret_cast<_ValueT*>(__buff.data()); }
+	static constexpr slots_t slots = make_slots();
 
-	template <class _ValueT>
-	const _ValueT& get() const { return *reinterpret_cast<const _ValueT*>(__buff.data()); }
+	// index of the stored type in _Ts, or not_found if it is none of them or if the any is empty
+	static std::size_t find(function_table_ptr_t function)
+	{
+		if (function == nullptr)
+			return not_found;
+
+		if (colliding)
+			return find_one_by_one(function, std::index_sequence_for<_Ts...>{});
+
+		const slot_t& s = slots.values[slot(function->type_hash)];
+		if (s.function == function)
+			return s.index;
+
+		if (s.function == nullptr || s.hash != function->type_hash)
+			return not_found;
+
+		count(function, counter::slow_type_check);
+		return *s.function->type == *function->type ? s.index : not_found;
+	}
 
 private:
-	template <class _ValueT>
-	void copy(_ValueT&& t)
+	template <std::size_t... _Is>
+	static std::size_t find_one_by_one(function_table_ptr_t function, std::index_sequence<_Is...>)
 	{
-		using NonConstT = std::remove_cv_t<std::remove_reference_t<_ValueT>>;
+		std::size_t index = not_found;
+		(void)std::initializer_list<int>{ (index == not_found && is_function_for_type<_Ts>(function) ? (index = _Is, 0) : 0)... };
+		return index;
+	}
+};
 
-#if __GNUG__ && __GNUC__ < 5
-		static_assert(std::has_trivial_copy_constructor<NonConstT>::value, "_ValueT is not trivially copyable");
-#else
-		static_assert(std::is_trivially_copyable<NonConstT>::value, "_ValueT is not trivially copyable");
-#endif
+template <class... _Ts>
+constexpr std::array<type_hash_t, sizeof...(_Ts)> type_index_map<_Ts...>::hashes;
 
-		static_assert(capacity() >= sizeof(_ValueT), "_ValueT is too big to be copied to static_any");
+template <class... _Ts>
+constexpr perfect_hash_t<sizeof...(_Ts)> type_index_map<_Ts...>::hash;
+
+template <class... _Ts>
+constexpr typename type_index_map<_Ts...>::slots_t type_index_map<_Ts...>::slots;
+
+// Jump table calling the visitor with the values of the anys, for each combination of the types _Ts: the
+// entry of the combination (i0, i1, ..., in) is at the index i0 * K^n + i1 * K^(n-1) + ... + in
+template <class _R, class _VisitorT, class _TypeList, class... _AnyTs>
+struct visit_table;
+
+template <class _R, class _VisitorT, class... _Ts, class... _AnyTs>
+struct visit_table<_R, _VisitorT, std::tuple<_Ts...>, _AnyTs...>
+{
+	static constexpr std::size_t types = sizeof...(_Ts);
+	static constexpr std::size_t arity = sizeof...(_AnyTs);
+
+	using function_t = _R(*)(_VisitorT&, _AnyTs&...);
+	using table_type = std::array<function_t, int_pow(types, arity)>;
 
-		std::memcpy(__buff.data(), reinterpret_cast<char*>(&t), sizeof(_ValueT));
+	template <std::size_t _Flat, std::size_t... _Pos>
+	static _R invoke_impl(_VisitorT& visitor, std::index_sequence<_Pos...>, _AnyTs&... anys)
+	{
+		return std::forward<_VisitorT>(visitor)(
+			any_access::get<nth_type_t<(_Flat / int_pow(types, arity - 1 - _Pos)) % types, _Ts...>>(anys)...);
+	}
+
+	template <std::size_t _Flat>
+	static _R invoke(_VisitorT& visitor, _AnyTs&... anys)
+	{
+		return invoke_impl<_Flat>(visitor, std::make_index_sequence<arity>{}, anys...);
+	}
+
+	template <std::size_t... _Flat>
+	static constexpr table_type make(std::index_sequence<_Flat...>)
+	{
+		return {{ &invoke<_Flat>... }};
+	}
+
+	static constexpr table_type table = make(std::make_index_sequence<int_pow(types, arity)>{});
+
+	// binary search of the entry, letting the compiler inline the visitor: used instead of the table when it is small
+	template <std::size_t _First, std::size_t _Last>
+	static _R dispatch(std::size_t, _VisitorT& visitor, _AnyTs&... anys, std::true_type)
+	{
+		return invoke<_First>(visitor, anys...);
+	}
+
+	template <std::size_t _First, std::size_t _Last>
+	static _R dispatch(std::size_t flat, _VisitorT& visitor, _AnyTs&... anys, std::false_type)
+	{
+		constexpr std::size_t middle = _First + (_Last - _First) / 2;
+		if (flat <= middle)
+			return dispatch<_First, middle>(flat, visitor, anys..., std::integral_constant<bool, _First == middle>{});
+		return dispatch<middle + 1, _Last>(flat, visitor, anys..., std::integral_constant<bool, middle + 1 == _Last>{});
 	}
 
-	std::array<char, _N> __buff;
+	static _R call(std::size_t flat, _VisitorT& visitor, _AnyTs&... anys)
+	{
+		constexpr std::size_t size = int_pow(types, arity);
+		return size <= 8 ?
+			dispatch<0, size - 1>(flat, visitor, anys..., std::integral_constant<bool, size == 1>{}) :
+			table[flat](visitor, anys...);
+	}
 };
+
+template <class _R, class _VisitorT, class... _Ts, class... _AnyTs>
+constexpr typename visit_table<_R, _VisitorT, std::tuple<_Ts...>, _AnyTs...>::table_type visit_table<_R, _VisitorT, std::tuple<_Ts...>, _AnyTs...>::table;
+
+struct throw_bad_visit
+{
+	template <class... _AnyTs>
+	[[noreturn]] void operator()(const _AnyTs&... anys) const
+	{
+		count(nullptr, counter::bad_cast);
+
+		const std::type_info* types[] = { &anys.type()... };
+		for (const std::type_info* type : types)
+			if (*type != typeid(void))
+				throw bad_any_cast(*type, typeid(void));
+		throw bad_any_cast(typeid(void), typeid(void));
+	}
+};
+
+template <class _R, class _FallbackT, class... _AnyTs>
+_R call_fallback(_FallbackT&& fallback, _AnyTs&... anys)
+{
+	return static_cast<_R>(std::forward<_FallbackT>(fallback)(anys...));
+}
+
+template <class _R, class... _AnyTs>
+[[noreturn]] _R call_fallback(throw_bad_visit fallback, _AnyTs&... anys)
+{
+	fallback(anys...);
+}
+
+template <class _R, class _TableT, class... _Ts, class _VisitorT, class _FallbackT, class... _AnyTs>
+_R visit_by_index(std::tuple<_Ts...>*, _VisitorT& visitor, _FallbackT&& fallback, _AnyTs&... anys)
+{
+	const std::size_t indexes[] = { type_index_map<_Ts...>::find(any_access::function(anys))... };
+
+	std::size_t flat = 0;
+	for (std::size_t index : indexes)
+	{
+		if (index == sizeof...(_Ts))
+			return call_fallback<_R>(std::forward<_FallbackT>(fallback), anys...);
+		flat = flat * sizeof...(_Ts) + index;
+	}
+
+	return _TableT::call(flat, visitor, anys...);
+}
+
+// A single any and a few types: the visitor is called as soon as the function table of the any is the one of a type
+// in this module, as a chain of has<_T>() would, without computing the index of the type first. The tables of other
+// modules are then found by index
+template <class _R, class _TableT, class _AllT, class _VisitorT, class _FallbackT, class _AnyT>
+_R visit_by_pointer(std::tuple<>*, _AllT* all, _VisitorT& visitor, _FallbackT&& fallback, _AnyT& any)
+{
+	return visit_by_index<_R, _TableT>(all, visitor, std::forward<_FallbackT>(fallback), any);
+}
+
+template <class _R, class _TableT, class _T, class... _Rest, class _AllT, class _VisitorT, class _FallbackT, class _AnyT>
+_R visit_by_pointer(std::tuple<_T, _Rest...>*, _AllT* all, _VisitorT& visitor, _FallbackT&& fallback, _AnyT& any)
+{
+	if (any_access::function(any) == get_function_for_type<_T>())
+		return _TableT::template invoke<_TableT::types - sizeof...(_Rest) - 1>(visitor, any);
+	return visit_by_pointer<_R, _TableT>(static_cast<std::tuple<_Rest...>*>(nullptr), all, visitor, std::forward<_FallbackT>(fallback), any);
+}
+
+constexpr std::size_t visit_by_pointer_max_types = 8;
+
+template <class _R, class _TableT, class _TypesT, class _VisitorT, class _FallbackT, class... _AnyTs>
+_R visit(std::false_type, _TypesT* types, _VisitorT& visitor, _FallbackT&& fallback, _AnyTs&... anys)
+{
+	return visit_by_index<_R, _TableT>(types, visitor, std::forward<_FallbackT>(fallback), anys...);
+}
+
+template <class _R, class _TableT, class _TypesT, class _VisitorT, class _FallbackT, class _AnyT>
+_R visit(std::true_type, _TypesT* types, _VisitorT& visitor, _FallbackT&& fallback, _AnyT& any)
+{
+	return visit_by_pointer<_R, _TableT>(types, types, visitor, std::forward<_FallbackT>(fallback), any);
+}
+
+template <class... _Ts, class _VisitorT, class _FallbackT, class... _AnyTs>
+decltype(auto) visit(_VisitorT&& visitor, _FallbackT&& fallback, _AnyTs&... anys)
+{
+	static_assert(sizeof...(_Ts) > 0, "no type to visit");
+	static_assert(sizeof...(_AnyTs) > 0, "no static_any to visit");
+	static_assert(are_distinct_types<_Ts...>::value, "duplicate types");
+
+	using first_t = nth_type_t<0, _Ts...>;
+	using result_t = decltype(std::forward<_VisitorT>(visitor)(any_access::get<first_t>(anys)...));
+	using table_t = visit_table<result_t, _VisitorT, std::tuple<_Ts...>, _AnyTs...>;
+	using by_pointer = std::integral_constant<bool, sizeof...(_AnyTs) == 1 && sizeof...(_Ts) <= visit_by_pointer_max_types>;
+
+	return visit<result_t, table_t>(by_pointer{}, static_cast<std::tuple<_Ts...>*>(nullptr), visitor, std::forward<_FallbackT>(fallback), anys...);
+}
+
+}}
+
+// Calls visitor(t0, t1, ...), t0 being the value stored in the first any, t1 in the second..., provided that
+// each of them stores one of the types _Ts, with a single indirect call. bad_any_cast is thrown otherwise,
+// its target_type() being typeid(void)
+template <class... _Ts, class _VisitorT, class... _AnyTs>
+decltype(auto) visit(_VisitorT&& visitor, _AnyTs&... anys)
+{
+	return detail::static_any::visit<_Ts...>(std::forward<_VisitorT>(visitor), detail::static_any::throw_bad_visit{}, anys...);
+}
+
+// Same as visit(), but calls fallback(any0, any1, ...) if one of the anys is empty or stores a type not in _Ts
+template <class... _Ts, class _VisitorT, class _FallbackT, class... _AnyTs>
+decltype(auto) visit_or(_VisitorT&& visitor, _FallbackT&& fallback, _AnyTs&... anys)
+{
+	return detail::static_any::visit<_Ts...>(std::forward<_VisitorT>(visitor), std::forward<_FallbackT>(fallback), anys...);
+}
+
+// Equal if both are empty, or store values of the same type that compare equal with its operator==. Throws
+// bad_any_comparison if that type has no operator==
+template <std::size_t _N, std::size_t _Align, std::size_t _M, std::size_t _MAlign>
+bool operator==(const static_any<_N, _Align>& a, const static_any<_M, _MAlign>& b)
+{
+	using access = detail::static_any::any_access;
+
+	const detail::static_any::function_table_ptr_t function = access::function(a);
+	const detail::static_any::function_table_ptr_t other_function = access::function(b);
+
+	if (function == nullptr || other_function == nullptr)
+		return function == other_function;
+
+	// compares the type headers first, as has<_T>(): the function tables differ across DLL boundaries
+	if (!detail::static_any::is_same_type(function, other_function))
+		return false;
+
+	return detail::static_any::equal_values(function, access::data(a), access::data(b));
+}
+
+template <std::size_t _N, std::size_t _Align, std::size_t _M, std::size_t _MAlign>
+bool operator!=(const static_any<_N, _Align>& a, const static_any<_M, _MAlign>& b)
+{
+	return !(a == b);
+}
+
+// more specialized than std::swap, which would move through a temporary: used by std::sort, std::iter_swap...
+template <std::size_t _N, std::size_t _Align>
+void swap(static_any<_N, _Align>& a, static_any<_N, _Align>& b)
+{
+	a.swap(b);
+}
+
+template <std::size_t _N, std::size_t _Align, std::size_t _M, std::size_t _MAlign>
+void swap(static_any<_N, _Align>& a, static_any<_M, _MAlign>& b)
+{
+	a.swap(b);
+}
+
+// Total order: empty anys first, then values ordered by the hash of their type, then by the operator< of their type.
+// Throws bad_any_comparison if two values of the same type are compared and that type has no operator<
+template <std::size_t _N, std::size_t _Align, std::size_t _M, std::size_t _MAlign>
+bool operator<(const static_any<_N, _Align>& a, const static_any<_M, _MAlign>& b)
+{
+	using access = detail::static_any::any_access;
+	return detail::static_any::less_values(access::function(a), access::data(a), access::function(b), access::data(b));
+}
+
+template <std::size_t _N, std::size_t _Align, std::size_t _M, std::size_t _MAlign>
+bool operator>(const static_any<_N, _Align>& a, const static_any<_M, _MAlign>& b)
+{
+	return b < a;
+}
+
+template <std::size_t _N, std::size_t _Align, std::size_t _M, std::size_t _MAlign>
+bool operator<=(const static_any<_N, _Align>& a, const static_any<_M, _MAlign>& b)
+{
+	return !(b < a);
+}
+
+template <std::size_t _N, std::size_t _Align, std::size_t _M, std::size_t _MAlign>
+bool operator>=(const static_any<_N, _Align>& a, const static_any<_M, _MAlign>& b)
+{
+	return !(a < b);
+}
+
+// comparator of std::map, std::sort..., comparing anys of any capacities with operator<
+struct static_any_less
+{
+	using is_transparent = void;
+
+	template <std::size_t _N, std::size_t _Align, std::size_t _M, std::size_t _MAlign>
+	bool operator()(const static_any<_N, _Align>& a, const static_any<_M, _MAlign>& b) const
+	{
+		return a < b;
+	}
+};
+
+// Hash of the stored value, combined with the hash of its type, 0 if empty. Throws bad_any_hash if the type is not
+// supported by std::hash
+namespace std {
+
+template <std::size_t _N, std::size_t _Align>
+struct hash<static_any<_N, _Align>>
+{
+	std::size_t operator()(const static_any<_N, _Align>& a) const
+	{
+		using access = detail::static_any::any_access;
+		return detail::static_any::hash_value(access::function(a), access::data(a));
+	}
+};
+
+}
+
+template <std::size_t _N, std::size_t _Align = detail::static_any::default_alignment(_N)>
+class static_any_t
+{
+public:
+	using size_type = std::size_t;
+
+	static constexpr size_type capacity() { return _N; }
+	static constexpr size_type alignment() { return _Align; }
+
+	static_any_t() = default;
+	static_any_t(const static_any_t&) = default;
+
+	// constexpr with C++20, see STATIC_ANY_CONSTEXPR_ANY_T: arrays of static_any_t can then be constant initialized
+	template <class _ValueT>
+	STATIC_ANY_CONSTEXPR static_any_t(_ValueT&& t)
+	{
+#if STATIC_ANY_CONSTEXPR_ANY_T
+		if (std::is_constant_evaluated())
+		{
+			__buff = detail::static_any::to_buffer<_N>(t);
+			return;
+		}
+#endif
+		copy(std::forward<_ValueT>(t));
+	}
+
+	template <class _ValueT>
+	static_any_t& operator=(_ValueT&& t)
+	{
+		copy(std::forward<_ValueT>(t));
+		return *this;
+	}
+
+	template <class _ValueT>
+	_ValueT& get() { return *reinterpret_cast<_ValueT*>(__buff.data()); }
+
+	template <class _ValueT>
+	const _ValueT& get() const { return *reinterpret_cast<const _ValueT*>(__buff.data()); }
+
+	// a copy of the value, unlike get() usable in constant expressions with C++20
+	template <class _ValueT>
+	STATIC_ANY_CONSTEXPR _ValueT value() const
+	{
+#if STATIC_ANY_CONSTEXPR_ANY_T
+		if (std::is_constant_evaluated())
+			return detail::static_any::from_buffer<_ValueT>(__buff);
+#endif
+		return get<_ValueT>();
+	}
+
+	template <class _ValueT, class... Args>
+	void emplace(Args&&... args)
+	{
+		static_assert(detail::static_any::is_trivially_copyable<_ValueT>::value, "_ValueT is not trivially copyable");
+
+		static_assert(capacity() >= sizeof(_ValueT), "_ValueT is too big to be copied to static_any");
+		static_assert(alignment() >= alignof(_ValueT), "_ValueT is too aligned to be copied to static_any");
+
+		new (__buff.data()) _ValueT(std::forward<Args>(args)...);
+	}
+
+private:
+	template <class _ValueT>
+	void copy(_ValueT&& t)
+	{
+		using NonConstT = std::remove_cv_t<std::remove_reference_t<_ValueT>>;
+
+		static_assert(detail::static_any::is_trivially_copyable<NonConstT>::value, "_ValueT is not trivially copyable");
+
+		static_assert(capacity() >= sizeof(_ValueT), "_ValueT is too big to be copied to static_any");
+		static_assert(alignment() >= alignof(NonConstT), "_ValueT is too aligned to be copied to static_any");
+
+		std::memcpy(__buff.data(), reinterpret_cast<const char*>(&t), sizeof(_ValueT));
+	}
+
+	alignas(_Align) std::array<char, _N> __buff;
+};
+
+template <std::size_t _N, class _TagT = std::uint8_t, std::size_t _Align = detail::static_any::default_alignment(_N)>
+class checked_static_any_t
+{
+	using registry = detail::static_any::type_registry<_TagT>;
+
+public:
+	using size_type = std::size_t;
+	using tag_type = _TagT;
+
+	template <class _T>
+	struct is_checked_static_any_t : public std::false_type {};
+
+	template <std::size_t _M, class _OtherTagT, std::size_t _MAlign>
+	struct is_checked_static_any_t<checked_static_any_t<_M, _OtherTagT, _MAlign>> : public std::true_type {};
+
+	static constexpr size_type capacity() { return _N; }
+	static constexpr size_type alignment() { return _Align; }
+
+	checked_static_any_t() = default;
+	checked_static_any_t(const checked_static_any_t&) = default;
+	checked_static_any_t& operator=(const checked_static_any_t&) = default;
+
+	template <class _ValueT,
+			  class = std::enable_if_t<!is_checked_static_any_t<std::decay_t<_ValueT>>::value>>
+	checked_static_any_t(_ValueT&& t)
+	{
+		copy(std::forward<_ValueT>(t));
+	}
+
+	template <class _ValueT,
+			  class = std::enable_if_t<!is_checked_static_any_t<std::decay_t<_ValueT>>::value>>
+	checked_static_any_t& operator=(_ValueT&& t)
+	{
+		copy(std::forward<_ValueT>(t));
+		return *this;
+	}
+
+	template <class _ValueT>
+	_ValueT& get()
+	{
+		check<_ValueT>();
+		return *reinterpret_cast<_ValueT*>(__buff.data());
+	}
+
+	template <class _ValueT>
+	const _ValueT& get() const
+	{
+		check<_ValueT>();
+		return *reinterpret_cast<const _ValueT*>(__buff.data());
+	}
+
+	// nullptr if the stored value is not a _ValueT
+	template <class _ValueT>
+	_ValueT* try_get() noexcept
+	{
+		return has<_ValueT>() ? reinterpret_cast<_ValueT*>(__buff.data()) : nullptr;
+	}
+
+	template <class _ValueT>
+	const _ValueT* try_get() const noexcept
+	{
+		return has<_ValueT>() ? reinterpret_cast<const _ValueT*>(__buff.data()) : nullptr;
+	}
+
+	// the stored value has to be a _ValueT, which is only asserted
+	template <class _ValueT>
+	_ValueT& unchecked_get() noexcept
+	{
+		assert(has<_ValueT>());
+		return *reinterpret_cast<_ValueT*>(__buff.data());
+	}
+
+	template <class _ValueT>
+	const _ValueT& unchecked_get() const noexcept
+	{
+		assert(has<_ValueT>());
+		return *reinterpret_cast<const _ValueT*>(__buff.data());
+	}
+
+	template <class _ValueT>
+	bool has() const { return !empty() && __tag == registry::template find<_ValueT>(); }
+
+	bool empty() const { return __tag == registry::empty_index; }
+
+	void reset() { __tag = registry::empty_index; }
+
+	tag_type tag() const { return __tag; }
+
+	const std::type_info& type() const
+	{
+		if (empty())
+			return typeid(void);
+		else
+			return *registry::function(__tag)->type;
+	}
+
+private:
+	template <class _ValueT>
+	void copy(_ValueT&& t)
+	{
+		using NonConstT = std::remove_cv_t<std::remove_reference_t<_ValueT>>;
+
+		static_assert(detail::static_any::is_trivially_copyable<NonConstT>::value, "_ValueT is not trivially copyable");
+
+		static_assert(capacity() >= sizeof(_ValueT), "_ValueT is too big to be copied to static_any");
+		static_assert(alignment() >= alignof(NonConstT), "_ValueT is too aligned to be copied to static_any");
+
+		std::memcpy(__buff.data(), reinterpret_cast<const char*>(&t), sizeof(_ValueT));
+		__tag = registry::template index<NonConstT>();
+	}
+
+	template <class _ValueT>
+	void check() const
+	{
+		if (!has<_ValueT>())
+		{
+			detail::static_any::count(empty() ? nullptr : registry::function(__tag), detail::static_any::counter::bad_cast);
+			throw bad_any_cast(type(), typeid(_ValueT));
+		}
+	}
+
+	alignas(_Align) std::array<char, _N> __buff;
+	tag_type __tag{registry::empty_index};
+};
+
+// static_any whose header is a 1 or 2 bytes index in the process-wide type registry instead of a pointer to
+// the function table. Use a capacity of k * Align - sizeof(IndexT) to avoid any padding, e.g. a
+// compact_static_any<15> takes 16 bytes
+template <std::size_t _N, class _IndexT = std::uint8_t, std::size_t _Align = detail::static_any::default_alignment(_N)>
+class compact_static_any
+{
+	using registry = detail::static_any::type_registry<_IndexT>;
+	using function_table_ptr_t = detail::static_any::function_table_ptr_t;
+
+public:
+	template <class _T>
+	struct is_compact_static_any : public std::false_type {};
+
+	template <std::size_t _M, std::size_t _MAlign>
+	struct is_compact_static_any<compact_static_any<_M, _IndexT, _MAlign>> : public std::true_type {};
+
+	using size_type = std::size_t;
+	using index_type = _IndexT;
+
+	compact_static_any() = default;
+
+	~compact_static_any() { destroy(); }
+
+	template <class _T,
+			  class = std::enable_if_t<!is_compact_static_any<std::decay_t<_T>>::value>>
+	compact_static_any(_T&& t)
+	{
+		construct(std::forward<_T>(t));
+	}
+
+	compact_static_any(const compact_static_any& another)
+	{
+		construct_from_any(another, detail::static_any::copy_tag{});
+	}
+
+	// noexcept as the move constructor of static_any: std::terminate is called if the move of the value throws
+	compact_static_any(compact_static_any&& another) noexcept
+	{
+		construct_from_any(another, detail::static_any::move_tag{});
+	}
+
+	template <std::size_t _M, std::size_t _MAlign, class = std::enable_if_t<_M <= _N && _MAlign <= _Align>>
+	compact_static_any(const compact_static_any<_M, _IndexT, _MAlign>& another)
+	{
+		construct_from_any(another, detail::static_any::copy_tag{});
+	}
+
+	template <std::size_t _M, std::size_t _MAlign, class = std::enable_if_t<_M <= _N && _MAlign <= _Align>>
+	compact_static_any(compact_static_any<_M, _IndexT, _MAlign>&& another)
+	{
+		construct_from_any(another, detail::static_any::move_tag{});
+	}
+
+	template <class _T,
+			  class = std::enable_if_t<!is_compact_static_any<std::decay_t<_T>>::value>>
+	compact_static_any& operator=(_T&& t);
+
+	compact_static_any& operator=(const compact_static_any& another)
+	{
+		assign_from_any(another, detail::static_any::copy_tag{});
+		return *this;
+	}
+
+	template <std::size_t _M, std::size_t _MAlign, class = std::enable_if_t<_M <= _N && _MAlign <= _Align>>
+	compact_static_any& operator=(const compact_static_any<_M, _IndexT, _MAlign>& another)
+	{
+		assign_from_any(another, detail::static_any::copy_tag{});
+		return *this;
+	}
+
+	template <std::size_t _M, std::size_t _MAlign, class = std::enable_if_t<_M <= _N && _MAlign <= _Align>>
+	compact_static_any& operator=(compact_static_any<_M, _IndexT, _MAlign>&& another)
+	{
+		assign_from_any(another, detail::static_any::move_tag{});
+		return *this;
+	}
+
+	void reset() { destroy(); }
+
+	template <class _T>
+	const _T& get() const
+	{
+		check<_T>();
+		return *reinterpret_cast<const _T*>(__buff.data());
+	}
+
+	template <class _T>
+	_T& get()
+	{
+		check<_T>();
+		return *reinterpret_cast<_T*>(__buff.data());
+	}
+
+	// nullptr if the stored value is not a _T
+	template <class _T>
+	const _T* try_get() const noexcept
+	{
+		return has<_T>() ? reinterpret_cast<const _T*>(__buff.data()) : nullptr;
+	}
+
+	template <class _T>
+	_T* try_get() noexcept
+	{
+		return has<_T>() ? reinterpret_cast<_T*>(__buff.data()) : nullptr;
+	}
+
+	// the stored value has to be a _T, which is only asserted
+	template <class _T>
+	const _T& unchecked_get() const noexcept
+	{
+		assert(has<_T>());
+		return *reinterpret_cast<const _T*>(__buff.data());
+	}
+
+	template <class _T>
+	_T& unchecked_get() noexcept
+	{
+		assert(has<_T>());
+		return *reinterpret_cast<_T*>(__buff.data());
+	}
+
+	template <class _T>
+	bool has() const { return !empty() && __index == registry::template find<_T>(); }
+
+	const std::type_info& type() const
+	{
+		if (empty())
+			return typeid(void);
+		else
+			return *function()->type;
+	}
+
+	bool empty() const { return __index == registry::empty_index; }
+
+	size_type size() const
+	{
+		if (empty())
+			return 0;
+		else
+			return function()->size;
+	}
+
+	index_type index() const { return __index; }
+
+	static constexpr size_type capacity() { return _N; }
+
+	static constexpr size_type alignment() { return _Align; }
+
+	template <class _T, class... Args>
+	void emplace(Args&&... args)
+	{
+		static_assert(capacity() >= sizeof(_T), "_T is too big to be copied to compact_static_any");
+		static_assert(alignment() >= alignof(_T), "_T is too aligned to be copied to compact_static_any");
+
+		destroy();
+
+		const index_type idx = registry::template index<_T>();
+		new(__buff.data()) _T(std::forward<Args>(args)...);
+		__index = idx;
+	}
+
+private:
+	function_table_ptr_t function() const
+	{
+		assert(!empty());
+		return registry::function(__index);
+	}
+
+	template <class _T>
+	void construct(_T&& t)
+	{
+		using NonConstT = std::remove_cv_t<std::remove_reference_t<_T>>;
+
+		static_assert(capacity() >= sizeof(NonConstT), "_T is too big to be copied to compact_static_any");
+		static_assert(alignment() >= alignof(NonConstT), "_T is too aligned to be copied to compact_static_any");
+		static_assert(std::is_constructible<NonConstT, _T&&>::value, "_T is not copy constructible, move only types have to be moved to compact_static_any");
+		assert(empty());
+
+		// registering the type may throw, do it before constructing the value
+		const index_type idx = registry::template index<NonConstT>();
+		new(__buff.data()) NonConstT(std::forward<_T>(t));
+		__index = idx;
+	}
+
+	template <std::size_t _M, std::size_t _MAlign, class CopyOrMoveTag>
+	void construct_from_any(const compact_static_any<_M, _IndexT, _MAlign>& another, CopyOrMoveTag)
+	{
+		assert(empty());
+
+		if (another.empty())
+			return;
+
+		function_table_ptr_t function = another.function();
+		void* other_data = reinterpret_cast<void*>(const_cast<char*>(another.__buff.data()));
+		detail::static_any::count(function, CopyOrMoveTag{});
+
+		if (function->trivial)
+			detail::static_any::trivial_copy<_M>(__buff.data(), other_data, function->size);
+		else
+			call_function(function, __buff.data(), other_data, CopyOrMoveTag{});
+
+		__index = another.__index;
+	}
+
+	template <std::size_t _M, std::size_t _MAlign, class CopyOrMoveTag>
+	void assign_from_any(const compact_static_any<_M, _IndexT, _MAlign>& another, CopyOrMoveTag)
+	{
+		if (static_cast<const void*>(&another) == static_cast<const void*>(this))
+			return;
+
+		if (another.empty() || empty() || is_nothrow_operation(another.function(), CopyOrMoveTag{}))
+		{
+			destroy();
+			construct_from_any(another, CopyOrMoveTag{});
+			return;
+		}
+
+		compact_static_any temp;
+		backup_to(temp);
+
+		try {
+			destroy();
+			construct_from_any(another, CopyOrMoveTag{});
+		}
+		catch(...) {
+			*this = std::move(temp);
+			throw;
+		}
+	}
+
+	void backup_to(compact_static_any& temp)
+	{
+		assert(!empty());
+		detail::static_any::count(function(), detail::static_any::counter::backup);
+
+		// see static_any::backup_to
+		if (function()->nothrow_move || !function()->copyable)
+			temp.construct_from_any(*this, detail::static_any::move_tag{});
+		else
+			temp.construct_from_any(*this, detail::static_any::copy_tag{});
+	}
+
+	void destroy()
+	{
+		if (!empty())
+		{
+			function_table_ptr_t f = function();
+			if (!f->trivial)
+				f->destroy(__buff.data());
+			__index = registry::empty_index;
+		}
+	}
+
+	template <class _T>
+	void check() const
+	{
+		if (!has<_T>())
+		{
+			detail::static_any::count(empty() ? nullptr : function(), detail::static_any::counter::bad_cast);
+			throw bad_any_cast(type(), typeid(_T));
+		}
+	}
+
+	static void call_function(function_table_ptr_t function, void* this_void_ptr, void* other_void_ptr, detail::static_any::move_tag)
+	{
+		function->move(this_void_ptr, other_void_ptr);
+	}
+
+	static void call_function(function_table_ptr_t function, void* this_void_ptr, void* other_void_ptr, detail::static_any::copy_tag)
+	{
+		function->copy(this_void_ptr, other_void_ptr);
+	}
+
+	static bool is_nothrow_operation(function_table_ptr_t function, detail::static_any::move_tag)
+	{
+		return function->nothrow_move;
+	}
+
+	static bool is_nothrow_operation(function_table_ptr_t function, detail::static_any::copy_tag)
+	{
+		return function->nothrow_copy;
+	}
+
+	alignas(_Align) std::array<char, _N> __buff;
+	index_type __index{registry::empty_index};
+
+	template <std::size_t _S, class _I, std::size_t _A>
+	friend class compact_static_any;
+};
+
+template <std::size_t _N, class _IndexT, std::size_t _Align>
+template <class _T, class>
+compact_static_any<_N, _IndexT, _Align>& compact_static_any<_N, _IndexT, _Align>::operator=(_T&& t)
+{
+	using NonConstT = std::remove_cv_t<std::remove_reference_t<_T>>;
+
+	// see static_any::operator=
+	if (std::is_nothrow_constructible<NonConstT, _T&&>::value || empty())
+	{
+		destroy();
+		construct(std::forward<_T>(t));
+		return *this;
+	}
+
+	compact_static_any temp;
+	backup_to(temp);
+
+	try {
+		destroy();
+		construct(std::forward<_T>(t));
+	}
+	catch(...) {
+		*this = std::move(temp);
+		throw;
+	}
+
+	return *this;
+}
+
+namespace detail { namespace static_any {
+
+// storage of the allocator of hybrid_static_any: empty allocators, e.g. std::allocator, take no space
+template <class _Alloc, bool = std::is_empty<_Alloc>::value && !std::is_final<_Alloc>::value>
+struct allocator_holder : private _Alloc
+{
+	explicit allocator_holder(const _Alloc& alloc) :
+		_Alloc(alloc)
+	{}
+
+	const _Alloc& allocator() const { return *this; }
+};
+
+template <class _Alloc>
+struct allocator_holder<_Alloc, false>
+{
+	explicit allocator_holder(const _Alloc& alloc) :
+		__alloc(alloc)
+	{}
+
+	const _Alloc& allocator() const { return __alloc; }
+
+private:
+	_Alloc __alloc;
+};
+
+}}
+
+// A static_any<_N> storing the values that do not fit in its buffer in memory obtained from _Alloc, instead of
+// failing to build: the buffer then holds a pointer to the value. _Alloc can be any allocator, e.g. a
+// std::pmr::polymorphic_allocator to allocate from a monotonic arena or a pool.
+//
+// Whether a value is spilled only depends on its type: moving a spilled value to another hybrid_static_any that
+// spills it too only transfers the pointer, provided that their allocators compare equal. As for containers, the
+// allocator is set at construction and never changes: assignments keep the allocator of the target. A moved-from
+// hybrid_static_any is empty.
+template <std::size_t _N, class _Alloc = std::allocator<char>, std::size_t _Align = detail::static_any::default_alignment(_N)>
+class hybrid_static_any : private detail::static_any::allocator_holder<_Alloc>
+{
+	static_assert(_N >= sizeof(void*) && _Align >= alignof(void*), "hybrid_static_any is too small to store a pointer");
+
+	using function_table_ptr_t = detail::static_any::function_table_ptr_t;
+	using holder = detail::static_any::allocator_holder<_Alloc>;
+
+	// spilled values are allocated as arrays of unit_t, aligned for any fundamental type
+	using unit_t = std::max_align_t;
+	using unit_allocator = typename std::allocator_traits<_Alloc>::template rebind_alloc<unit_t>;
+	using unit_traits = std::allocator_traits<unit_allocator>;
+
+public:
+	template <typename _T>
+	struct is_hybrid_static_any : public std::false_type {};
+
+	template <std::size_t _M, std::size_t _MAlign>
+	struct is_hybrid_static_any<hybrid_static_any<_M, _Alloc, _MAlign>> : public std::true_type {};
+
+	using size_type = std::size_t;
+	using allocator_type = _Alloc;
+
+	// values of type _T are stored in the buffer if true, allocated otherwise
+	template <class _T>
+	static constexpr bool is_inline() { return sizeof(_T) <= _N && alignof(_T) <= _Align; }
+
+	hybrid_static_any() :
+		holder(_Alloc())
+	{}
+
+	explicit hybrid_static_any(const _Alloc& alloc) :
+		holder(alloc)
+	{}
+
+	~hybrid_static_any() { destroy(); }
+
+	// an allocator is not a value: use emplace() to store one
+	template <class _T,
+			  class = std::enable_if_t<!is_hybrid_static_any<std::decay_t<_T>>::value &&
+									   !std::is_same<std::decay_t<_T>, _Alloc>::value &&
+									   !std::is_same<std::decay_t<_T>, std::allocator_arg_t>::value>>
+	hybrid_static_any(_T&& t) :
+		holder(_Alloc())
+	{
+		construct<std::remove_cv_t<std::remove_reference_t<_T>>>(std::forward<_T>(t));
+	}
+
+	template <class _T,
+			  class = std::enable_if_t<!is_hybrid_static_any<std::decay_t<_T>>::value>>
+	hybrid_static_any(std::allocator_arg_t, const _Alloc& alloc, _T&& t) :
+		holder(alloc)
+	{
+		construct<std::remove_cv_t<std::remove_reference_t<_T>>>(std::forward<_T>(t));
+	}
+
+	hybrid_static_any(const hybrid_static_any& another) :
+		holder(std::allocator_traits<_Alloc>::select_on_container_copy_construction(another.get_allocator()))
+	{
+		construct_from_any(another, detail::static_any::copy_tag{});
+	}
+
+	template <std::size_t _M, std::size_t _MAlign>
+	hybrid_static_any(const hybrid_static_any<_M, _Alloc, _MAlign>& another) :
+		holder(std::allocator_traits<_Alloc>::select_on_container_copy_construction(another.get_allocator()))
+	{
+		construct_from_any(another, detail::static_any::copy_tag{});
+	}
+
+	// noexcept as the move constructor of static_any: a spilled value only moves its pointer, the allocators being equal,
+	// and std::terminate is called if the move of an inline value throws
+	hybrid_static_any(hybrid_static_any&& another) noexcept :
+		holder(another.get_allocator())
+	{
+		construct_from_any(another, detail::static_any::move_tag{});
+	}
+
+	template <std::size_t _M, std::size_t _MAlign>
+	hybrid_static_any(hybrid_static_any<_M, _Alloc, _MAlign>&& another) :
+		holder(another.get_allocator())
+	{
+		construct_from_any(another, detail::static_any::move_tag{});
+	}
+
+	template <class _T,
+			  class = std::enable_if_t<!is_hybrid_static_any<std::decay_t<_T>>::value>>
+	hybrid_static_any& operator=(_T&& t);
+
+	hybrid_static_any& operator=(const hybrid_static_any& another)
+	{
+		assign_from_any(another, detail::static_any::copy_tag{});
+		return *this;
+	}
+
+	template <std::size_t _M, std::size_t _MAlign>
+	hybrid_static_any& operator=(const hybrid_static_any<_M, _Alloc, _MAlign>& another)
+	{
+		assign_from_any(another, detail::static_any::copy_tag{});
+		return *this;
+	}
+
+	hybrid_static_any& operator=(hybrid_static_any&& another)
+	{
+		assign_from_any(another, detail::static_any::move_tag{});
+		return *this;
+	}
+
+	template <std::size_t _M, std::size_t _MAlign>
+	hybrid_static_any& operator=(hybrid_static_any<_M, _Alloc, _MAlign>&& another)
+	{
+		assign_from_any(another, detail::static_any::move_tag{});
+		return *this;
+	}
+
+	void reset() { destroy(); }
+
+	template <class _T>
+	const _T& get() const
+	{
+		check<_T>();
+		return *as<_T>();
+	}
+
+	template <class _T>
+	_T& get()
+	{
+		check<_T>();
+		return *const_cast<_T*>(as<_T>());
+	}
+
+	// nullptr if the stored value is not a _T
+	template <class _T>
+	const _T* try_get() const noexcept
+	{
+		return has<_T>() ? as<_T>() : nullptr;
+	}
+
+	template <class _T>
+	_T* try_get() noexcept
+	{
+		return has<_T>() ? const_cast<_T*>(as<_T>()) : nullptr;
+	}
+
+	// the stored value has to be a _T, which is only asserted
+	template <class _T>
+	const _T& unchecked_get() const noexcept
+	{
+		assert(has<_T>());
+		return *as<_T>();
+	}
+
+	template <class _T>
+	_T& unchecked_get() noexcept
+	{
+		assert(has<_T>());
+		return *const_cast<_T*>(as<_T>());
+	}
+
+	template <class _T>
+	bool has() const
+	{
+		return __function != nullptr && detail::static_any::is_function_for_type<_T>(__function);
+	}
+
+	const std::type_info& type() const
+	{
+		if (empty())
+			return typeid(void);
+		else
+			return *__function->type;
+	}
+
+	bool empty() const { return __function == nullptr; }
+
+	// true if the stored value has been allocated
+	bool spilled() const { return !empty() && is_spilled(__function); }
+
+	size_type size() const
+	{
+		if (empty())
+			return 0;
+		else
+			return __function->size;
+	}
+
+	allocator_type get_allocator() const { return holder::allocator(); }
+
+	static constexpr size_type capacity() { return _N; }
+
+	static constexpr size_type alignment() { return _Align; }
+
+	template <class _T, class... Args>
+	void emplace(Args&&... args)
+	{
+		destroy();
+		construct<_T>(std::forward<Args>(args)...);
+	}
+
+private:
+	static bool is_spilled(function_table_ptr_t function)
+	{
+		return function->size > _N || function->alignment > _Align;
+	}
+
+	// values more aligned than unit_t are inline in a hybrid_static_any<_M, _Alloc, _MAlign>: true if some would be
+	// spilled here, and then allocated misaligned
+	template <std::size_t _M, std::size_t _MAlign>
+	static constexpr bool may_spill_over_aligned()
+	{
+		return _MAlign > alignof(unit_t) && (_M > _N || _MAlign > _Align);
+	}
+
+	static std::size_t units(std::size_t size)
+	{
+		return (size + sizeof(unit_t) - 1) / sizeof(unit_t);
+	}
+
+	void* allocate(std::size_t size)
+	{
+		unit_allocator alloc(holder::allocator());
+		return unit_traits::allocate(alloc, units(size));
+	}
+
+	void deallocate(void* data, std::size_t size)
+	{
+		unit_allocator alloc(holder::allocator());
+		unit_traits::deallocate(alloc, static_cast<unit_t*>(data), units(size));
+	}
+
+	void*& spilled_data() { return *reinterpret_cast<void**>(__buff.data()); }
+
+	void* const& spilled_data() const { return *reinterpret_cast<void* const*>(__buff.data()); }
+
+	void* data() { return is_spilled(__function) ? spilled_data() : __buff.data(); }
+
+	const void* data() const { return is_spilled(__function) ? spilled_data() : __buff.data(); }
+
+	template <class _T>
+	const _T* as() const
+	{
+		// known at compile time, unlike is_spilled()
+		return reinterpret_cast<const _T*>(is_inline<_T>() ? __buff.data() : spilled_data());
+	}
+
+	template <class _T, class... Args>
+	void construct(Args&&... args)
+	{
+		static_assert(is_inline<_T>() || alignof(_T) <= alignof(unit_t), "_T is too aligned to be allocated by hybrid_static_any");
+		static_assert(std::is_constructible<_T, Args&&...>::value, "_T is not constructible from these arguments, move only types have to be moved to hybrid_static_any");
+		assert(empty());
+
+		if (is_inline<_T>())
+		{
+			new(__buff.data()) _T(std::forward<Args>(args)...);
+		}
+		else
+		{
+			void* data = allocate(sizeof(_T));
+			try {
+				new(data) _T(std::forward<Args>(args)...);
+			}
+			catch(...) {
+				deallocate(data, sizeof(_T));
+				throw;
+			}
+			spilled_data() = data;
+		}
+
+		__function = detail::static_any::get_function_for_type<_T>();
+	}
+
+	template <std::size_t _M, std::size_t _MAlign>
+	void construct_from_any(const hybrid_static_any<_M, _Alloc, _MAlign>& another, detail::static_any::copy_tag)
+	{
+		assert(empty());
+
+		if (!another.empty())
+			construct_value<_M, _MAlign>(another.__function, const_cast<void*>(another.data()), detail::static_any::copy_tag{});
+	}
+
+	template <std::size_t _M, std::size_t _MAlign>
+	void construct_from_any(hybrid_static_any<_M, _Alloc, _MAlign>& another, detail::static_any::move_tag)
+	{
+		assert(empty());
+
+		if (another.empty())
+			return;
+
+		function_table_ptr_t function = another.__function;
+		if (is_spilled(function) && another.is_spilled(function) && get_allocator() == another.get_allocator())
+		{
+			detail::static_any::count(function, detail::static_any::move_tag{});
+			spilled_data() = another.spilled_data();
+			__function = function;
+			another.__function = nullptr;
+			return;
+		}
+
+		construct_value<_M, _MAlign>(function, another.data(), detail::static_any::move_tag{});
+		another.destroy();
+	}
+
+	// other_data is in the buffer of a hybrid_static_any<_M, _Alloc, _MAlign>, or allocated if the value is spilled there
+	template <std::size_t _M, std::size_t _MAlign, class CopyOrMoveTag>
+	void construct_value(function_table_ptr_t function, void* other_data, CopyOrMoveTag)
+	{
+		const bool spill = is_spilled(function);
+		if (may_spill_over_aligned<_M, _MAlign>() && spill && function->alignment > alignof(unit_t))
+			throw bad_any_alignment(*function->type);
+
+		detail::static_any::count(function, CopyOrMoveTag{});
+
+		void* data = spill ? allocate(function->size) : __buff.data();
+
+		try {
+			if (function->trivial && !spill && !hybrid_static_any<_M, _Alloc, _MAlign>::is_spilled(function))
+				detail::static_any::trivial_copy<(_M < _N ? _M : _N)>(data, other_data, function->size);
+			else if (function->trivial)
+				std::memcpy(data, other_data, function->size);
+			else
+				call_function(function, data, other_data, CopyOrMoveTag{});
+		}
+		catch(...) {
+			if (spill)
+				deallocate(data, function->size);
+			throw;
+		}
+
+		if (spill)
+			spilled_data() = data;
+		__function = function;
+	}
+
+	template <class _AnyT, class CopyOrMoveTag>
+	void assign_from_any(_AnyT& another, CopyOrMoveTag)
+	{
+		if (static_cast<const void*>(&another) == static_cast<const void*>(this))
+			return;
+
+		if (another.empty() || empty() || is_nothrow_construction(another, CopyOrMoveTag{}))
+		{
+			destroy();
+			construct_from_any(another, CopyOrMoveTag{});
+			return;
+		}
+
+		hybrid_static_any temp(get_allocator());
+		backup_to(temp);
+
+		try {
+			construct_from_any(another, CopyOrMoveTag{});
+		}
+		catch(...) {
+			construct_from_any(temp, detail::static_any::move_tag{});
+			throw;
+		}
+	}
+
+	// leaves *this empty
+	void backup_to(hybrid_static_any& temp)
+	{
+		assert(!empty());
+		detail::static_any::count(__function, detail::static_any::counter::backup);
+
+		// see static_any::backup_to; a spilled value is only moved by pointer
+		if (is_spilled(__function) || __function->nothrow_move || !__function->copyable)
+		{
+			temp.construct_from_any(*this, detail::static_any::move_tag{});
+		}
+		else
+		{
+			temp.construct_from_any(*this, detail::static_any::copy_tag{});
+			destroy();
+		}
+	}
+
+	void destroy()
+	{
+		if (__function)
+		{
+			void* value = data();
+			if (!__function->trivial)
+				__function->destroy(value);
+			if (is_spilled(__function))
+				deallocate(value, __function->size);
+			__function = nullptr;
+		}
+	}
+
+	template <class _T>
+	void check() const
+	{
+		if (!has<_T>())
+		{
+			detail::static_any::count(__function, detail::static_any::counter::bad_cast);
+			throw bad_any_cast(type(), typeid(_T));
+		}
+	}
+
+	static void call_function(function_table_ptr_t function, void* this_void_ptr, void* other_void_ptr, detail::static_any::move_tag)
+	{
+		function->move(this_void_ptr, other_void_ptr);
+	}
+
+	static void call_function(function_table_ptr_t function, void* this_void_ptr, void* other_void_ptr, detail::static_any::copy_tag)
+	{
+		function->copy(this_void_ptr, other_void_ptr);
+	}
+
+	template <std::size_t _M, std::size_t _MAlign>
+	bool is_nothrow_construction(const hybrid_static_any<_M, _Alloc, _MAlign>& another, detail::static_any::copy_tag) const
+	{
+		return !is_spilled(another.__function) && another.__function->nothrow_copy;
+	}
+
+	template <std::size_t _M, std::size_t _MAlign>
+	bool is_nothrow_construction(const hybrid_static_any<_M, _Alloc, _MAlign>& another, detail::static_any::move_tag) const
+	{
+		function_table_ptr_t function = another.__function;
+		if (is_spilled(function))
+			return another.is_spilled(function) && get_allocator() == another.get_allocator();
+		return function->nothrow_move;
+	}
+
+	alignas(_Align) std::array<char, _N> __buff;
+	function_table_ptr_t __function{};
+
+	template <std::size_t _S, class _A, std::size_t _SAlign>
+	friend class hybrid_static_any;
+};
+
+template <std::size_t _N, class _Alloc, std::size_t _Align>
+template <class _T, class>
+hybrid_static_any<_N, _Alloc, _Align>& hybrid_static_any<_N, _Alloc, _Align>::operator=(_T&& t)
+{
+	using NonConstT = std::remove_cv_t<std::remove_reference_t<_T>>;
+
+	// see static_any::operator=; spilling the value allocates, which may throw
+	if ((is_inline<NonConstT>() && std::is_nothrow_constructible<NonConstT, _T&&>::value) || empty())
+	{
+		destroy();
+		construct<NonConstT>(std::forward<_T>(t));
+		return *this;
+	}
+
+	hybrid_static_any temp(get_allocator());
+	backup_to(temp);
+
+	try {
+		construct<NonConstT>(std::forward<_T>(t));
+	}
+	catch(...) {
+		construct_from_any(temp, detail::static_any::move_tag{});
+		throw;
+	}
+
+	return *this;
+}
@@ -1,184 +1,635 @@
 #include "../any.hpp"
+#include "../static_any_vector.hpp"
+#include "../static_any_map.hpp"
 
-#include <geiger/geiger.h>
+#include <benchmark/benchmark.h>
 
-#include <boost/any.hpp>
-#include <QVariant>
-#include <experimental/any>
+#include <algorithm>
+#include <any>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
 
-struct small_struct
+template <std::size_t _S>
+struct payload
 {
-	int i;
-	void* v;
-	double d;
-
-	int h() const { return i; }
+	std::array<char, _S> data;
 };
 
-Q_DECLARE_METATYPE(std::string)
-Q_DECLARE_METATYPE(small_struct)
+using payload_8 = payload<8>;
+using payload_32 = payload<32>;
+using payload_64 = payload<64>;
+
+using static_any_64 = static_any<64>;
+using static_any_t_64 = static_any_t<64>;
+using checked_static_any_t_64 = checked_static_any_t<64>;
+using compact_static_any_64 = compact_static_any<64>;
+using hybrid_static_any_16 = hybrid_static_any<16>;
+using variant_64 = std::variant<payload_8, payload_32, payload_64, std::string>;
+
+template <class _T>
+_T make_value() { return _T{}; }
+
+template <>
+std::string make_value<std::string>() { return std::string(48, 'x'); }
+
+// uniform access to the containers being compared
+
+template <class _T, class _AnyT>
+const _T& any_get(const _AnyT& a) { return a.template get<_T>(); }
+
+template <class _T>
+const _T& any_get(const std::any& a) { return *std::any_cast<_T>(&a); }
+
+template <class _T, class... _Ts>
+const _T& any_get(const std::variant<_Ts...>& v) { return *std::get_if<_T>(&v); }
+
+template <class _T, class _AnyT>
+bool any_has(const _AnyT& a) { return a.template has<_T>(); }
+
+template <class _T>
+bool any_has(const std::any& a) { return a.type() == typeid(_T); }
+
+template <class _T, class... _Ts>
+bool any_has(const std::variant<_Ts...>& v) { return std::holds_alternative<_T>(v); }
+
+template <class _AnyT, class _T>
+void construct(benchmark::State& state)
+{
+	const _T value = make_value<_T>();
+	for (auto _ : state)
+	{
+		_AnyT a(value);
+		benchmark::DoNotOptimize(a);
+	}
+}
 
-int main()
+template <class _AnyT, class _T>
+void assign(benchmark::State& state)
 {
-	qRegisterMetaType<std::string>();
-	qRegisterMetaType<small_struct>();
+	const _T value = make_value<_T>();
+	_AnyT a(value);
+	for (auto _ : state)
+	{
+		a = value;
+		benchmark::DoNotOptimize(a);
+	}
+}
 
-	geiger::init();
-	geiger::suite<> s;
+template <class _AnyT, class _T>
+void copy(benchmark::State& state)
+{
+	const _AnyT a(make_value<_T>());
+	for (auto _ : state)
+	{
+		_AnyT b(a);
+		benchmark::DoNotOptimize(b);
+	}
+}
 
-	s.add("qvariant double assignment", []()
+template <class _AnyT, class _T>
+void move(benchmark::State& state)
+{
+	_AnyT a(make_value<_T>());
+	for (auto _ : state)
 	{
-		QVariant q;
-		q = .3224;
-	});
-	s.add("boost.any double assignment", []()
+		_AnyT b(std::move(a));
+		a = std::move(b);
+		benchmark::DoNotOptimize(a);
+	}
+}
+
+template <class _AnyT, class _T>
+void get(benchmark::State& state)
+{
+	const _AnyT a(make_value<_T>());
+	for (auto _ : state)
 	{
-		boost::any a;
-		a = .3224;
-	});
-	s.add("std::any double assignment", []()
+		benchmark::DoNotOptimize(a);
+		benchmark::DoNotOptimize(any_get<_T>(a));
+	}
+}
+
+template <class _AnyT, class _T>
+void has(benchmark::State& state)
+{
+	const _AnyT a(make_value<_T>());
+	for (auto _ : state)
 	{
-		std::experimental::any a;
-		a = .2342;
-	});
-	s.add("static_any<8> double assignment", []()
+		benchmark::DoNotOptimize(a);
+		benchmark::DoNotOptimize(any_has<_T>(a));
+	}
+}
+
+template <class _AnyT>
+void type(benchmark::State& state)
+{
+	const _AnyT a(std::string("foobar"));
+	for (auto _ : state)
 	{
-		static_any<8> a;
-		a = .2342;
-	});
-	s.add("static_any_t<8> double assignment", []()
+		benchmark::DoNotOptimize(a);
+		benchmark::DoNotOptimize(&a.type());
+	}
+}
+
+template <class _AnyT>
+void size(benchmark::State& state)
+{
+	const _AnyT a(std::string("foobar"));
+	for (auto _ : state)
 	{
-		static_any_t<8> a;
-		a = .2342;
-	});
+		benchmark::DoNotOptimize(a);
+		benchmark::DoNotOptimize(a.size());
+	}
+}
 
-	double d = .42;
+// storing then destroying the value: reset() alone would only destroy the first one
+template <class _AnyT, class _T>
+void destroy(benchmark::State& state)
+{
+	const _T value = make_value<_T>();
+	_AnyT a;
+	for (auto _ : state)
+	{
+		a.template emplace<_T>(value);
+		benchmark::DoNotOptimize(a);
+		a.reset();
+		benchmark::ClobberMemory();
+	}
+}
 
-	QVariant qd = d;
-	boost::any bda = d;
-	std::experimental::any stdda = d;
-	static_any<8> sda = d;
-	static_any_t<8> stda = d;
+template <class _AnyT, class _BiggerAnyT, class _T>
+void cross_capacity_copy(benchmark::State& state)
+{
+	const _AnyT a(make_value<_T>());
+	for (auto _ : state)
+	{
+		_BiggerAnyT b(a);
+		benchmark::DoNotOptimize(b);
+	}
+}
 
-	int sum = 0;
+template <class _AnyT, class _BiggerAnyT, class _T>
+void cross_capacity_move(benchmark::State& state)
+{
+	_AnyT a(make_value<_T>());
+	for (auto _ : state)
+	{
+		_BiggerAnyT b(std::move(a));
+		benchmark::DoNotOptimize(b);
+		a = make_value<_T>();
+	}
+}
 
-	s.add("qvariant get double", [&sum, &qd]()
+// get() of the wrong type: throwing and catching the exception
+template <class _AnyT>
+void bad_cast(benchmark::State& state)
+{
+	const _AnyT a(3.14);
+	for (auto _ : state)
 	{
-		sum += qd.toDouble();
-	});
-	s.add("boost.any get double", [&sum, &bda]()
+		try
+		{
+			benchmark::DoNotOptimize(a.template get<int>());
+		}
+		catch (const bad_any_cast& e)
+		{
+			benchmark::DoNotOptimize(&e);
+		}
+	}
+}
+
+template <>
+void bad_cast<std::any>(benchmark::State& state)
+{
+	const std::any a(3.14);
+	for (auto _ : state)
 	{
-		sum += boost::any_cast<double>(bda);
-	});
-	s.add("std::any get double", [&sum, &stdda]()
+		try
+		{
+			benchmark::DoNotOptimize(std::any_cast<int>(a));
+		}
+		catch (const std::bad_any_cast& e)
+		{
+			benchmark::DoNotOptimize(&e);
+		}
+	}
+}
+
+// try_get() of the wrong type: no exception
+template <class _AnyT>
+void try_get_miss(benchmark::State& state)
+{
+	const _AnyT a(3.14);
+	for (auto _ : state)
 	{
-		sum += std::experimental::any_cast<double>(stdda);
-	});
-	s.add("static_any<8> get double", [&sum, &sda]()
+		benchmark::DoNotOptimize(a);
+		benchmark::DoNotOptimize(a.template try_get<int>());
+	}
+}
+
+template <>
+void try_get_miss<std::any>(benchmark::State& state)
+{
+	const std::any a(3.14);
+	for (auto _ : state)
 	{
-		sum += any_cast<double>(sda);
-	});
-	s.add("static_any_t<8> get double", [&sum, &stda]()
+		benchmark::DoNotOptimize(a);
+		benchmark::DoNotOptimize(std::any_cast<int>(&a));
+	}
+}
+
+#define STATIC_ANY_BENCHMARK_PAYLOADS(bench, any_type) \
+	BENCHMARK_TEMPLATE(bench, any_type, payload_8); \
+	BENCHMARK_TEMPLATE(bench, any_type, payload_32); \
+	BENCHMARK_TEMPLATE(bench, any_type, payload_64)
+
+#define STATIC_ANY_BENCHMARK_ALL_PAYLOADS(bench, any_type) \
+	STATIC_ANY_BENCHMARK_PAYLOADS(bench, any_type); \
+	BENCHMARK_TEMPLATE(bench, any_type, std::string)
+
+// static_any_t and checked_static_any_t only store trivially copyable types
+#define STATIC_ANY_BENCHMARK_OPERATION(bench) \
+	STATIC_ANY_BENCHMARK_ALL_PAYLOADS(bench, std::any); \
+	STATIC_ANY_BENCHMARK_ALL_PAYLOADS(bench, variant_64); \
+	STATIC_ANY_BENCHMARK_ALL_PAYLOADS(bench, static_any_64); \
+	STATIC_ANY_BENCHMARK_PAYLOADS(bench, static_any_t_64); \
+	STATIC_ANY_BENCHMARK_PAYLOADS(bench, checked_static_any_t_64); \
+	STATIC_ANY_BENCHMARK_ALL_PAYLOADS(bench, compact_static_any_64); \
+	STATIC_ANY_BENCHMARK_ALL_PAYLOADS(bench, hybrid_static_any_16)
+
+STATIC_ANY_BENCHMARK_OPERATION(construct);
+STATIC_ANY_BENCHMARK_OPERATION(assign);
+STATIC_ANY_BENCHMARK_OPERATION(copy);
+STATIC_ANY_BENCHMARK_OPERATION(move);
+STATIC_ANY_BENCHMARK_OPERATION(get);
+
+STATIC_ANY_BENCHMARK_ALL_PAYLOADS(has, std::any);
+STATIC_ANY_BENCHMARK_ALL_PAYLOADS(has, variant_64);
+STATIC_ANY_BENCHMARK_ALL_PAYLOADS(has, static_any_64);
+STATIC_ANY_BENCHMARK_ALL_PAYLOADS(has, compact_static_any_64);
+STATIC_ANY_BENCHMARK_ALL_PAYLOADS(has, hybrid_static_any_16);
+
+BENCHMARK_TEMPLATE(type, std::any);
+BENCHMARK_TEMPLATE(type, static_any_64);
+BENCHMARK_TEMPLATE(type, compact_static_any_64);
+BENCHMARK_TEMPLATE(type, hybrid_static_any_16);
+
+BENCHMARK_TEMPLATE(size, static_any_64);
+BENCHMARK_TEMPLATE(size, compact_static_any_64);
+BENCHMARK_TEMPLATE(size, hybrid_static_any_16);
+
+STATIC_ANY_BENCHMARK_ALL_PAYLOADS(destroy, std::any);
+STATIC_ANY_BENCHMARK_ALL_PAYLOADS(destroy, static_any_64);
+STATIC_ANY_BENCHMARK_ALL_PAYLOADS(destroy, compact_static_any_64);
+STATIC_ANY_BENCHMARK_ALL_PAYLOADS(destroy, hybrid_static_any_16);
+
+BENCHMARK_TEMPLATE(cross_capacity_copy, static_any<32>, static_any_64, payload_32);
+BENCHMARK_TEMPLATE(cross_capacity_copy, static_any<32>, static_any_64, std::string);
+BENCHMARK_TEMPLATE(cross_capacity_copy, compact_static_any<47>, compact_static_any_64, std::string);
+BENCHMARK_TEMPLATE(cross_capacity_copy, hybrid_static_any_16, hybrid_static_any<32>, payload_64);
+BENCHMARK_TEMPLATE(cross_capacity_move, static_any<32>, static_any_64, std::string);
+BENCHMARK_TEMPLATE(cross_capacity_move, hybrid_static_any_16, hybrid_static_any<32>, payload_64);
+
+BENCHMARK_TEMPLATE(bad_cast, std::any);
+BENCHMARK_TEMPLATE(bad_cast, static_any_64);
+BENCHMARK_TEMPLATE(bad_cast, compact_static_any_64);
+BENCHMARK_TEMPLATE(bad_cast, hybrid_static_any_16);
+BENCHMARK_TEMPLATE(try_get_miss, std::any);
+BENCHMARK_TEMPLATE(try_get_miss, static_any_64);
+BENCHMARK_TEMPLATE(try_get_miss, compact_static_any_64);
+BENCHMARK_TEMPLATE(try_get_miss, hybrid_static_any_16);
+
+// move only and reference counted values
+
+template <class _PtrT>
+void pointer_move(benchmark::State& state)
+{
+	static_any<16> a = _PtrT(new int(7));
+	for (auto _ : state)
 	{
-		sum += stda.get<double>();
-	});
+		static_any<16> b(std::move(a));
+		a = std::move(b);
+		benchmark::DoNotOptimize(a);
+	}
+}
 
-	s.add("qvariant small_struct assignment", []()
+BENCHMARK_TEMPLATE(pointer_move, std::unique_ptr<int>);
+BENCHMARK_TEMPLATE(pointer_move, std::shared_ptr<int>);
+
+void shared_ptr_copy(benchmark::State& state)
+{
+	static_any<16> a = std::make_shared<int>(7);
+	for (auto _ : state)
 	{
-		QVariant q;
-		q.setValue(small_struct{2, nullptr, .45});
-	});
-	s.add("boost.any small_struct assignment", []()
+		static_any<16> b(a);
+		benchmark::DoNotOptimize(b);
+	}
+}
+
+BENCHMARK(shared_ptr_copy);
+
+// containers of 1000 values
+
+struct small_struct
+{
+	int i;
+	void* v;
+	double d;
+};
+
+void vector_copy(benchmark::State& state)
+{
+	std::vector<static_any<32>> anys;
+	for (int i = 0; i < 1000; ++i)
+		anys.emplace_back(small_struct{i, nullptr, .45});
+
+	for (auto _ : state)
 	{
-		boost::any a;
-		a = small_struct{2, nullptr, .45};
-	});
-	s.add("std::any small_struct assignment", []()
+		auto v = anys;
+		benchmark::DoNotOptimize(v.data());
+	}
+}
+
+BENCHMARK(vector_copy);
+
+void aligned_get(benchmark::State& state)
+{
+	std::vector<static_any_t<8>> doubles(1000, static_any_t<8>(.42));
+	for (auto _ : state)
 	{
-		std::experimental::any a;
-		a = small_struct{2, nullptr, .45};
-	});
-	s.add("static_any<32> small_struct assignment", []()
+		double total = .0;
+		for (const auto& a : doubles)
+			total += a.get<double>();
+		benchmark::DoNotOptimize(total);
+	}
+}
+
+// 9-byte cells: a static_any_t<8> without alignment
+void misaligned_get(benchmark::State& state)
+{
+	const double d = .42;
+	std::vector<char> packed(1000 * (sizeof(double) + 1));
+	for (std::size_t i = 0; i < packed.size(); i += sizeof(double) + 1)
+		std::memcpy(&packed[i], &d, sizeof(double));
+
+	for (auto _ : state)
 	{
-		static_any<32> a;
-		a = small_struct{2, nullptr, .45};
-	});
-	s.add("static_any_t<32> small_struct assignment", []()
+		double total = .0;
+		for (std::size_t i = 0; i < packed.size(); i += sizeof(double) + 1)
+		{
+			double v;
+			std::memcpy(&v, &packed[i], sizeof(double));
+			total += v;
+		}
+		benchmark::DoNotOptimize(total);
+	}
+}
+
+BENCHMARK(aligned_get);
+BENCHMARK(misaligned_get);
+
+template <class _ContainerT>
+void fill_mixed(_ContainerT& c)
+{
+	for (int i = 0; i < 1000; ++i)
 	{
-		static_any_t<32> a;
-		a = small_struct{2, nullptr, .45};
-	});
+		switch (i % 4)
+		{
+		case 0: c.push_back(i); break;
+		case 1: c.push_back(i * .5); break;
+		case 2: c.push_back(static_cast<float>(i)); break;
+		default: c.push_back(static_cast<long>(i)); break;
+		}
+	}
+}
 
-	small_struct sss{2, nullptr, .45};
-	QVariant qs;
-	qs.setValue(sss);
-	boost::any bas = sss;
-	std::experimental::any stdsa = sss;
-	static_any<32> ssa = sss;
+struct to_double
+{
+	template <class _T>
+	double operator()(_T t) const { return static_cast<double>(t); }
+};
 
-	s.add("qvariant get small_struct", [&sum, &qs]()
+void mixed_has_chain(benchmark::State& state)
+{
+	std::vector<static_any<16>> anys;
+	fill_mixed(anys);
+
+	for (auto _ : state)
 	{
-		sum += qs.value<small_struct>().h();
-	});
-	s.add("boost.any get small_struct", [&sum, &bas]()
+		double total = .0;
+		for (const auto& a : anys)
+		{
+			if (a.has<int>())
+				total += a.get<int>();
+			else if (a.has<double>())
+				total += a.get<double>();
+			else if (a.has<float>())
+				total += static_cast<double>(a.get<float>());
+			else if (a.has<long>())
+				total += static_cast<double>(a.get<long>());
+		}
+		benchmark::DoNotOptimize(total);
+	}
+}
+
+void mixed_visit(benchmark::State& state)
+{
+	std::vector<static_any<16>> anys;
+	fill_mixed(anys);
+
+	for (auto _ : state)
 	{
-		sum += boost::any_cast<small_struct>(bas).h();
-	});
-	s.add("std::any get small_struct", [&sum, &stdsa]()
+		double total = .0;
+		for (const auto& a : anys)
+			total += visit<int, double, float, long>(to_double{}, a);
+		benchmark::DoNotOptimize(total);
+	}
+}
+
+void mixed_std_visit(benchmark::State& state)
+{
+	std::vector<std::variant<int, double, float, long>> variants;
+	fill_mixed(variants);
+
+	for (auto _ : state)
 	{
-		sum += std::experimental::any_cast<small_struct>(stdsa).h();
-	});
-	s.add("static_any<32> get small_struct", [&sum, &ssa]()
+		double total = .0;
+		for (const auto& v : variants)
+			total += std::visit(to_double{}, v);
+		benchmark::DoNotOptimize(total);
+	}
+}
+
+void mixed_static_any_vector(benchmark::State& state)
+{
+	static_any_vector<16> vector;
+	fill_mixed(vector);
+
+	for (auto _ : state)
 	{
-		sum += any_cast<small_struct>(ssa).h();
-	});
+		double total = .0;
+		vector.visit<int, double, float, long>([&total](auto v) { total += static_cast<double>(v); });
+		benchmark::DoNotOptimize(total);
+	}
+}
 
+BENCHMARK(mixed_has_chain);
+BENCHMARK(mixed_visit);
+BENCHMARK(mixed_std_visit);
+BENCHMARK(mixed_static_any_vector);
 
-	s.add("qvariant string assignment", []()
+// swapping two anys: the member swap, or three moves through a temporary as the generic std::swap
+
+template <class _T>
+void member_swap(benchmark::State& state)
+{
+	static_any_64 a = make_value<_T>();
+	static_any_64 b = make_value<_T>();
+	for (auto _ : state)
 	{
-		QVariant q;
-		q.setValue(std::string("foobar"));
-	});
-	s.add("boost.any string assignment", []()
+		a.swap(b);
+		benchmark::DoNotOptimize(a);
+		benchmark::DoNotOptimize(b);
+	}
+}
+
+template <class _T>
+void three_moves_swap(benchmark::State& state)
+{
+	static_any_64 a = make_value<_T>();
+	static_any_64 b = make_value<_T>();
+	for (auto _ : state)
 	{
-		boost::any a;
-		a = std::string("foobar");
-	});
-	s.add("std::any string assignment", []()
+		static_any_64 temp(std::move(a));
+		a = std::move(b);
+		b = std::move(temp);
+		benchmark::DoNotOptimize(a);
+		benchmark::DoNotOptimize(b);
+	}
+}
+
+BENCHMARK_TEMPLATE(member_swap, payload_32);
+BENCHMARK_TEMPLATE(member_swap, std::string);
+BENCHMARK_TEMPLATE(three_moves_swap, payload_32);
+BENCHMARK_TEMPLATE(three_moves_swap, std::string);
+
+// growing a std::vector<static_any<32>> of strings. The std::string of libstdc++ points into itself (small string
+// optimization) and is not trivially relocatable: the strings are backed by a std::vector<char>, with or without the
+// trait
+
+template <bool _Relocatable>
+struct heap_string
+{
+	explicit heap_string(std::size_t size) : chars(size, 'x') {}
+	std::vector<char> chars;
+};
+
+template <>
+struct static_any_trivially_relocatable<heap_string<true>> : std::true_type {};
+
+template <class _T>
+void vector_growth(benchmark::State& state)
+{
+	for (auto _ : state)
 	{
-		std::experimental::any a;
-		a = std::string("foobar");
-	});
-	s.add("static_any<32> string assignment", []()
+		std::vector<static_any<32>> v;
+		for (int i = 0; i < 1000; ++i)
+			v.emplace_back(_T(16));
+		benchmark::DoNotOptimize(v.data());
+	}
+}
+
+BENCHMARK_TEMPLATE(vector_growth, heap_string<false>);
+BENCHMARK_TEMPLATE(vector_growth, heap_string<true>);
+
+// sorting mixed values, ordered by type then value
+
+template <class _ContainerT>
+void fill_mixed_random(_ContainerT& c, std::size_t size)
+{
+	std::mt19937 generator(42);
+	std::uniform_int_distribution<int> distribution(0, 1 << 20);
+
+	c.reserve(size);
+	for (std::size_t i = 0; i < size; ++i)
 	{
-		static_any<32> a;
-		a = std::string("foobar");
-	});
+		const int v = distribution(generator);
+		switch (i % 4)
+		{
+		case 0: c.push_back(v); break;
+		case 1: c.push_back(v * .5); break;
+		case 2: c.push_back(static_cast<float>(v)); break;
+		default: c.push_back(static_cast<long>(v)); break;
+		}
+	}
+}
 
-	QVariant qstr;
-	qstr.setValue(std::string("foobar"));
-	boost::any bstr = std::string("foobar");
-	std::experimental::any astr = std::string("foobar");
-	static_any<32> sstr = std::string("foobar");
+template <class _ContainerT>
+void sort_mixed(benchmark::State& state)
+{
+	_ContainerT values;
+	fill_mixed_random(values, static_cast<std::size_t>(state.range(0)));
 
-	s.add("qvariant get string", [&sum, &qstr]()
+	for (auto _ : state)
 	{
-		sum += qstr.value<std::string>().size();
-	});
-	s.add("boost.any get string", [&sum, &bstr]()
+		state.PauseTiming();
+		_ContainerT v = values;
+		state.ResumeTiming();
+
+		std::sort(v.begin(), v.end());
+		benchmark::DoNotOptimize(v.data());
+	}
+}
+
+BENCHMARK_TEMPLATE(sort_mixed, std::vector<static_any<16>>)->Arg(1 << 16)->Arg(10000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(sort_mixed, std::vector<std::variant<int, double, float, long>>)->Arg(1 << 16)->Arg(10000000)->Unit(benchmark::kMillisecond);
+
+// memoization by heterogeneous keys, half ints and half strings: serialized to a std::string, or stored as they are
+
+std::string serialize_key(int i) { return "i:" + std::to_string(i); }
+std::string serialize_key(const std::string& s) { return "s:" + s; }
+
+void memo_serialized_key(benchmark::State& state)
+{
+	std::unordered_map<std::string, int> cache;
+	for (int i = 0; i < 1000; ++i)
 	{
-		sum += boost::any_cast<std::string>(bstr).size();
-	});
-	s.add("std::any get string", [&sum, &astr]()
+		cache.emplace(serialize_key(i), i);
+		cache.emplace(serialize_key(std::to_string(i)), i);
+	}
+
+	const std::string key = std::to_string(742);
+	for (auto _ : state)
 	{
-		sum += std::experimental::any_cast<std::string>(astr).size();
-	});
-	s.add("static_any<32> get string", [&sum, &sstr]()
+		int total = cache.find(serialize_key(742))->second + cache.find(serialize_key(key))->second;
+		benchmark::DoNotOptimize(total);
+	}
+}
+
+void memo_static_any_map(benchmark::State& state)
+{
+	static_any_map<32, int> cache;
+	for (int i = 0; i < 1000; ++i)
 	{
-		sum += any_cast<std::string>(sstr).size();
-	});
+		cache.try_emplace(i, i);
+		cache.try_emplace(std::to_string(i), i);
+	}
 
-	s.set_printer<geiger::printer::console<>>();
-	s.run();
+	const std::string key = std::to_string(742);
+	for (auto _ : state)
+	{
+		int total = *cache.find(742) + *cache.find(key);
+		benchmark::DoNotOptimize(total);
+	}
 }
 
+BENCHMARK(memo_serialized_key);
+BENCHMARK(memo_static_any_map);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,71 @@
+#include "../static_function.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <functional>
+
+// captures of 8 bytes, fitting in the small buffer of std::function, and of 32 bytes, allocated by it
+template <std::size_t _S>
+struct capture
+{
+	capture() { data.fill(1); }
+	std::array<char, _S> data;
+};
+
+template <std::size_t _S>
+auto make_callable()
+{
+	capture<_S> c;
+	return [c](int i) { return i + c.data[_S - 1]; };
+}
+
+template <class _FunctionT, std::size_t _S>
+void invoke(benchmark::State& state)
+{
+	_FunctionT f = make_callable<_S>();
+	int i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(f);
+		i = f(i);
+	}
+	benchmark::DoNotOptimize(i);
+}
+
+template <class _FunctionT, std::size_t _S>
+void construct(benchmark::State& state)
+{
+	auto callable = make_callable<_S>();
+	for (auto _ : state)
+	{
+		_FunctionT f = callable;
+		benchmark::DoNotOptimize(f);
+	}
+}
+
+template <class _FunctionT, std::size_t _S>
+void copy(benchmark::State& state)
+{
+	_FunctionT f = make_callable<_S>();
+	for (auto _ : state)
+	{
+		_FunctionT g(f);
+		benchmark::DoNotOptimize(g);
+	}
+}
+
+using std_function = std::function<int(int)>;
+using static_function_48 = static_function<int(int), 48>;
+
+#define FUNCTION_BENCHMARK(bench) \
+	BENCHMARK_TEMPLATE(bench, std_function, 8); \
+	BENCHMARK_TEMPLATE(bench, std_function, 32); \
+	BENCHMARK_TEMPLATE(bench, static_function_48, 8); \
+	BENCHMARK_TEMPLATE(bench, static_function_48, 32)
+
+FUNCTION_BENCHMARK(invoke);
+FUNCTION_BENCHMARK(construct);
+FUNCTION_BENCHMARK(copy);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+// Hardware counters of the calling thread, read through perf_event_open(2). The counters are opened as one group, so
+// that they are all measured over the same instructions; the ones the machine (or the kernel settings, see
+// /proc/sys/kernel/perf_event_paranoid) does not provide are just not available.
+class perf_counters
+{
+public:
+	enum metric
+	{
+		instructions,
+		cycles,
+		branch_misses,
+		l1d_misses,
+		metric_count
+	};
+
+	using values = std::array<double, metric_count>;
+
+	static const char* name(metric m)
+	{
+		static const char* names[metric_count] = {"instructions", "cycles", "branch-misses", "L1d-misses"};
+		return names[m];
+	}
+
+	perf_counters()
+	{
+		__fds.fill(-1);
+
+		for (int m = 0; m < metric_count; ++m)
+		{
+			perf_event_attr attr;
+			std::memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.disabled = __leader == -1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			set_event(attr, metric(m));
+
+			const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, __leader, 0));
+			if (fd == -1)
+				continue;
+
+			if (__leader == -1)
+				__leader = fd;
+			__fds[m] = fd;
+			__group_index[m] = __group_size++;
+		}
+	}
+
+	~perf_counters()
+	{
+		for (int fd : __fds)
+			if (fd != -1)
+				close(fd);
+	}
+
+	perf_counters(const perf_counters&) = delete;
+	perf_counters& operator=(const perf_counters&) = delete;
+
+	bool available(metric m) const { return __fds[m] != -1; }
+	bool any_available() const { return __leader != -1; }
+
+	void start()
+	{
+		ioctl(__leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(__leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+
+	void stop()
+	{
+		ioctl(__leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+	}
+
+	// counts between start() and stop(), scaled up if the group has been multiplexed with other events; -1 for the
+	// metrics not available
+	values read() const
+	{
+		struct
+		{
+			std::uint64_t count;
+			std::uint64_t time_enabled;
+			std::uint64_t time_running;
+			std::uint64_t values[metric_count];
+		} group;
+
+		values result;
+		result.fill(-1.);
+
+		if (::read(__leader, &group, sizeof(group)) <= 0 || group.time_running == 0)
+			return result;
+
+		const double scale = double(group.time_enabled) / double(group.time_running);
+		for (int m = 0; m < metric_count; ++m)
+			if (available(metric(m)))
+				result[m] = double(group.values[__group_index[m]]) * scale;
+
+		return result;
+	}
+
+private:
+	static void set_event(perf_event_attr& attr, metric m)
+	{
+		switch (m)
+		{
+		case instructions:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case cycles:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case branch_misses:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+			break;
+		case l1d_misses:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		case metric_count:
+			break;
+		}
+	}
+
+	std::array<int, metric_count> __fds;
+	std::array<std::size_t, metric_count> __group_index{};
+	std::size_t __group_size = 0;
+	int __leader = -1;
+};
@@ -0,0 +1,396 @@
+#include "../any.hpp"
+#include "perf_counters.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Hardware counters per operation, recorded to a baseline file and compared against it:
+//
+//   perf_regression                                       prints the counters of each operation
+//   perf_regression record <baseline>                     writes them to the baseline file
+//   perf_regression compare <baseline> [--threshold=<%>]  fails if a metric regresses past the threshold, or if the
+//                                                         baseline misses operations
+//
+// Each operation runs in a loop, whose own cost (the same loop, empty) is subtracted. The result of an operation is
+// the minimum over several runs: instructions are deterministic, cycles and misses only get noise on top of them.
+
+namespace
+{
+
+template <class _T>
+inline void escape(_T& t)
+{
+	asm volatile("" : : "r"(&t) : "memory");
+}
+
+using values = perf_counters::values;
+
+constexpr long iterations = 100000;
+constexpr int runs = 15;
+
+// relative threshold per metric, in percent, overridden by --threshold
+const double default_thresholds[perf_counters::metric_count] = {1., 10., 10., 10.};
+
+// below this difference (per operation), a metric has not regressed whatever the threshold: branch or cache misses
+// going from 0.01 to 0.02 are noise
+constexpr double absolute_tolerance = .5;
+
+struct operation
+{
+	std::string name;
+	void (*run)(long);
+};
+
+template <class _AnyT, class _T>
+void get(long n)
+{
+	_AnyT a{_T()};
+	for (long i = 0; i < n; ++i)
+	{
+		escape(a);
+		const _T& t = a.template get<_T>();
+		escape(t);
+	}
+}
+
+template <class _AnyT, class _T>
+void has(long n)
+{
+	_AnyT a{_T()};
+	for (long i = 0; i < n; ++i)
+	{
+		escape(a);
+		bool b = a.template has<_T>();
+		escape(b);
+	}
+}
+
+template <class _AnyT, class _T>
+void assign(long n)
+{
+	_AnyT a;
+	const _T t{};
+	for (long i = 0; i < n; ++i)
+	{
+		escape(a);
+		a = t;
+	}
+}
+
+template <class _AnyT, class _T>
+void copy(long n)
+{
+	const _AnyT a{_T()};
+	for (long i = 0; i < n; ++i)
+	{
+		_AnyT b(a);
+		escape(b);
+	}
+}
+
+void empty_loop(long n)
+{
+	for (long i = 0; i < n; ++i)
+	{
+		int j = 0;
+		escape(j);
+	}
+}
+
+template <class _AnyT>
+void add_operations(std::vector<operation>& operations, const std::string& any)
+{
+	operations.push_back({any + "::get<double>", &get<_AnyT, double>});
+	operations.push_back({any + "::operator=(double)", &assign<_AnyT, double>});
+	operations.push_back({any + "::" + any.substr(0, any.find('<')) + "(const&)", &copy<_AnyT, double>});
+}
+
+// the anys knowing the type of their value (i.e. not static_any_t)
+template <class _AnyT>
+void add_typed_operations(std::vector<operation>& operations, const std::string& any)
+{
+	operations.push_back({any + "::has<double>", &has<_AnyT, double>});
+	operations.push_back({any + "::get<std::string>", &get<_AnyT, std::string>});
+	operations.push_back({any + "::operator=(std::string)", &assign<_AnyT, std::string>});
+}
+
+std::vector<operation> all_operations()
+{
+	std::vector<operation> operations;
+	add_operations<static_any<64>>(operations, "static_any<64>");
+	add_typed_operations<static_any<64>>(operations, "static_any<64>");
+	add_operations<static_any_t<64>>(operations, "static_any_t<64>");
+	add_operations<compact_static_any<64>>(operations, "compact_static_any<64>");
+	add_typed_operations<compact_static_any<64>>(operations, "compact_static_any<64>");
+	add_operations<hybrid_static_any<16>>(operations, "hybrid_static_any<16>");
+	add_typed_operations<hybrid_static_any<16>>(operations, "hybrid_static_any<16>");
+	return operations;
+}
+
+values measure(perf_counters& counters, void (*run)(long))
+{
+	run(iterations / 10);
+
+	values best;
+	best.fill(-1.);
+
+	for (int r = 0; r < runs; ++r)
+	{
+		counters.start();
+		run(iterations);
+		counters.stop();
+
+		const values counts = counters.read();
+		for (int m = 0; m < perf_counters::metric_count; ++m)
+			if (counts[m] >= 0. && (best[m] < 0. || counts[m] < best[m]))
+				best[m] = counts[m];
+	}
+
+	for (double& v : best)
+		if (v >= 0.)
+			v /= iterations;
+	return best;
+}
+
+using results = std::vector<std::pair<std::string, values>>;
+
+results measure_all(perf_counters& counters)
+{
+	const values overhead = measure(counters, &empty_loop);
+
+	results res;
+	for (const operation& op : all_operations())
+	{
+		values v = measure(counters, op.run);
+		for (int m = 0; m < perf_counters::metric_count; ++m)
+			if (v[m] >= 0.)
+				v[m] = std::max(0., v[m] - overhead[m]);
+		res.emplace_back(op.name, v);
+	}
+	return res;
+}
+
+std::string environment()
+{
+	std::string cpu = "unknown";
+	std::ifstream cpuinfo("/proc/cpuinfo");
+	for (std::string line; std::getline(cpuinfo, line);)
+	{
+		if (line.compare(0, 10, "model name") == 0)
+		{
+			cpu = line.substr(line.find(':') + 2);
+			break;
+		}
+	}
+
+#if defined(__clang__)
+	const std::string compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+	const std::string compiler = "GCC " __VERSION__;
+#else
+	const std::string compiler = "unknown";
+#endif
+
+	return compiler + ", " + cpu;
+}
+
+void print_header(std::ostream& os)
+{
+	os << std::left;
+	os.width(52);
+	os << "operation";
+	for (int m = 0; m < perf_counters::metric_count; ++m)
+	{
+		os << ' ';
+		os.width(14);
+		os << perf_counters::name(perf_counters::metric(m));
+	}
+	os << '\n';
+}
+
+std::string format(double v)
+{
+	if (v < 0.)
+		return "-";
+
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.2f", v);
+	return buffer;
+}
+
+// baseline: "# <environment>" line, then "<operation> <metric>=<value>..." lines, "-" for a metric not available
+void write_baseline(std::ostream& os, const results& res)
+{
+	os << "# " << environment() << '\n';
+	for (const auto& r : res)
+	{
+		os << r.first;
+		for (int m = 0; m < perf_counters::metric_count; ++m)
+			os << ' ' << perf_counters::name(perf_counters::metric(m)) << '=' << format(r.second[m]);
+		os << '\n';
+	}
+}
+
+bool read_baseline(const char* path, std::map<std::string, values>& baseline, std::string& env)
+{
+	std::ifstream file(path);
+	if (!file)
+		return false;
+
+	for (std::string line; std::getline(file, line);)
+	{
+		if (line.empty())
+			continue;
+
+		if (line[0] == '#')
+		{
+			env = line.substr(line.find_first_not_of("# "));
+			continue;
+		}
+
+		std::istringstream is(line);
+		std::string name, field;
+		is >> name;
+
+		values& v = baseline[name];
+		v.fill(-1.);
+		while (is >> field)
+		{
+			const std::size_t equal = field.find('=');
+			for (int m = 0; m < perf_counters::metric_count; ++m)
+				if (field.compare(0, equal, perf_counters::name(perf_counters::metric(m))) == 0 && field.substr(equal + 1) != "-")
+					v[m] = std::atof(field.c_str() + equal + 1);
+		}
+	}
+	return true;
+}
+
+int compare(const results& res, const char* path, const double (&thresholds)[perf_counters::metric_count])
+{
+	std::map<std::string, values> baseline;
+	std::string env;
+	if (!read_baseline(path, baseline, env))
+	{
+		std::cerr << "cannot read the baseline " << path << '\n';
+		return 2;
+	}
+
+	// nothing to compare against is a failure, not a success
+	if (baseline.empty())
+	{
+		std::cerr << "the baseline " << path << " has no operation: record it with \"make perf_record\"\n";
+		return 2;
+	}
+
+	if (env != environment())
+		std::cerr << "warning: the baseline was recorded with " << env << ", not " << environment() << "\n\n";
+
+	int regressions = 0;
+	int missing = 0;
+	std::cout << std::left;
+	for (const auto& r : res)
+	{
+		const auto it = baseline.find(r.first);
+		if (it == baseline.end())
+		{
+			++missing;
+			std::cout << r.first << ": not in the baseline   MISSING\n";
+			continue;
+		}
+
+		for (int m = 0; m < perf_counters::metric_count; ++m)
+		{
+			const double before = it->second[m];
+			const double after = r.second[m];
+			if (after < 0.)
+				continue;
+
+			if (before < 0.)
+			{
+				std::cerr << "warning: " << r.first << ": " << perf_counters::name(perf_counters::metric(m))
+						  << " not in the baseline\n";
+				continue;
+			}
+
+			const bool regressed = after - before >= absolute_tolerance && after > before * (1. + thresholds[m] / 100.);
+			regressions += regressed;
+
+			std::cout.width(52);
+			std::cout << r.first << ' ';
+			std::cout.width(14);
+			std::cout << perf_counters::name(perf_counters::metric(m)) << ' ' << format(before) << " -> " << format(after)
+					  << (regressed ? "   REGRESSION" : "") << '\n';
+		}
+	}
+
+	std::cout << '\n' << regressions << " regression(s)";
+	if (missing != 0)
+		std::cout << ", " << missing << " operation(s) missing from the baseline: record it again with \"make perf_record\"";
+	std::cout << '\n';
+	return regressions == 0 && missing == 0 ? 0 : 1;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const std::string mode = argc > 1 ? argv[1] : "";
+	if ((mode != "" && mode != "record" && mode != "compare") || (mode != "" && argc < 3))
+	{
+		std::cerr << "usage: " << argv[0] << " [record <baseline> | compare <baseline> [--threshold=<percent>]]\n";
+		return 2;
+	}
+
+	double thresholds[perf_counters::metric_count];
+	std::copy(std::begin(default_thresholds), std::end(default_thresholds), thresholds);
+	if (argc > 3 && std::strncmp(argv[3], "--threshold=", 12) == 0)
+		std::fill(std::begin(thresholds), std::end(thresholds), std::atof(argv[3] + 12));
+
+	perf_counters counters;
+	if (!counters.any_available())
+	{
+		std::cerr << "perf_event_open: no hardware counter available (see /proc/sys/kernel/perf_event_paranoid, or the "
+					 "virtual machine may not expose the PMU)\n";
+		return 2;
+	}
+
+	for (int m = 0; m < perf_counters::metric_count; ++m)
+		if (!counters.available(perf_counters::metric(m)))
+			std::cerr << "warning: " << perf_counters::name(perf_counters::metric(m)) << " not available\n";
+
+	const results res = measure_all(counters);
+
+	if (mode == "record")
+	{
+		std::ofstream file(argv[2]);
+		write_baseline(file, res);
+		return file ? 0 : 2;
+	}
+
+	if (mode == "compare")
+		return compare(res, argv[2], thresholds);
+
+	print_header(std::cout);
+	for (const auto& r : res)
+	{
+		std::cout.width(52);
+		std::cout << r.first;
+		for (double v : r.second)
+		{
+			std::cout << ' ';
+			std::cout.width(14);
+			std::cout << format(v);
+		}
+		std::cout << '\n';
+	}
+	return 0;
+}
@@ -0,0 +1,290 @@
+#include "../static_any_queue.hpp"
+
+#include <algorithm>
+#include <any>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+struct order
+{
+	int id;
+	double price;
+	long quantity;
+};
+
+class mutex_queue
+{
+public:
+	template <class _T>
+	bool try_push(_T&& t)
+	{
+		std::lock_guard<std::mutex> lock(__mutex);
+		__queue.push(std::forward<_T>(t));
+		return true;
+	}
+
+	template <class _VisitorT>
+	bool try_consume(_VisitorT&& visitor)
+	{
+		std::any a;
+		{
+			std::lock_guard<std::mutex> lock(__mutex);
+			if (__queue.empty())
+				return false;
+			a = std::move(__queue.front());
+			__queue.pop();
+		}
+		visitor(a);
+		return true;
+	}
+
+	void flush() {}
+
+private:
+	std::mutex __mutex;
+	std::queue<std::any> __queue;
+};
+
+template <class _QueueT>
+auto flush(_QueueT& q, int) -> decltype(q.flush())
+{
+	q.flush();
+}
+
+// mpmc_queue: values are visible as soon as pushed
+template <class _QueueT>
+void flush(_QueueT&, long)
+{}
+
+using clock_type = std::chrono::steady_clock;
+
+static long messages = 10000000;
+
+struct stop {};
+
+static bool is_stop(const static_any<32>& a)
+{
+	return a.has<stop>();
+}
+
+static bool is_stop(const std::any& a)
+{
+	return a.type() == typeid(stop);
+}
+
+static double sum_of(const static_any<32>& a)
+{
+	return a.has<order>() ? a.get<order>().price : a.get<double>();
+}
+
+static double sum_of(const std::any& a)
+{
+	return a.type() == typeid(order) ? std::any_cast<const order&>(a).price : std::any_cast<double>(a);
+}
+
+// one producer, one consumer: messages per second
+template <class _QueueT>
+void throughput(const char* name, _QueueT& q)
+{
+	const auto start = clock_type::now();
+
+	std::thread producer([&q]()
+	{
+		for (long i = 0; i < messages; ++i)
+		{
+			if (i % 2 == 0)
+				while (!q.try_push(order{int(i), 1.0, i}));
+			else
+				while (!q.try_push(1.0));
+		}
+		q.flush();
+	});
+
+	double sum = .0;
+	for (long consumed = 0; consumed < messages;)
+		if (q.try_consume([&sum](const auto& a) { sum += sum_of(a); }))
+			++consumed;
+
+	producer.join();
+
+	const std::chrono::duration<double> elapsed = clock_type::now() - start;
+	std::printf("%-40s %10.1f M msg/s (%.0f)\n", name, messages / elapsed.count() / 1e6, sum);
+}
+
+// push and consume in the same thread, by bursts of 1000 messages: cost of the operations themselves, without
+// any cache line transfer
+template <class _QueueT>
+void single_thread(const char* name, _QueueT& q)
+{
+	const auto start = clock_type::now();
+
+	double sum = .0;
+	for (long i = 0; i < messages; i += 1000)
+	{
+		for (long j = i; j < i + 1000; ++j)
+		{
+			if (j % 2 == 0)
+				q.try_push(order{int(j), 1.0, j});
+			else
+				q.try_push(1.0);
+		}
+		flush(q, 0);
+
+		while (q.try_consume([&sum](const auto& a) { sum += sum_of(a); }));
+	}
+
+	const std::chrono::duration<double, std::nano> elapsed = clock_type::now() - start;
+	std::printf("%-40s %10.1f ns push + consume (%.0f)\n", name, elapsed.count() / messages, sum);
+}
+
+// ping-pong between two threads: average round-trip time
+template <class _QueueT>
+void latency(const char* name, _QueueT& ping, _QueueT& pong)
+{
+	const long round_trips = messages / 10;
+
+	std::thread echo([&ping, &pong, round_trips]()
+	{
+		for (long i = 0; i < round_trips; ++i)
+		{
+			while (!ping.try_consume([&pong](const auto&) { pong.try_push(1.0); pong.flush(); }));
+		}
+	});
+
+	const auto start = clock_type::now();
+	for (long i = 0; i < round_trips; ++i)
+	{
+		ping.try_push(1.0);
+		ping.flush();
+		while (!pong.try_consume([](const auto&) {}));
+	}
+	const std::chrono::duration<double, std::nano> elapsed = clock_type::now() - start;
+
+	echo.join();
+	std::printf("%-40s %10.0f ns round trip\n", name, elapsed.count() / round_trips);
+}
+
+// producers threads pushing messages, consumers threads consuming them until they get a stop message: messages per
+// second
+template <class _QueueT>
+void scaling(const char* name, _QueueT& q, int producers, int consumers)
+{
+	const auto start = clock_type::now();
+
+	std::vector<std::thread> producer_threads;
+	for (int p = 0; p < producers; ++p)
+	{
+		producer_threads.emplace_back([&q, p, producers]()
+		{
+			for (long i = p; i < messages; i += producers)
+			{
+				if (i % 2 == 0)
+					while (!q.try_push(order{int(i), 1.0, i}));
+				else
+					while (!q.try_push(1.0));
+			}
+		});
+	}
+
+	std::vector<std::thread> consumer_threads;
+	std::vector<double> sums(std::size_t(consumers), .0);
+	for (int c = 0; c < consumers; ++c)
+	{
+		consumer_threads.emplace_back([&q, &sums, c]()
+		{
+			bool stopped = false;
+			double sum = .0;
+			while (!stopped)
+			{
+				q.try_consume([&sum, &stopped](const auto& a)
+				{
+					if (is_stop(a))
+						stopped = true;
+					else
+						sum += sum_of(a);
+				});
+			}
+			sums[std::size_t(c)] = sum;
+		});
+	}
+
+	for (std::thread& t : producer_threads)
+		t.join();
+	for (int c = 0; c < consumers; ++c)
+		while (!q.try_push(stop{}));
+	for (std::thread& t : consumer_threads)
+		t.join();
+
+	const std::chrono::duration<double> elapsed = clock_type::now() - start;
+
+	double sum = .0;
+	for (double s : sums)
+		sum += s;
+	std::printf("%-40s %2dP %2dC %8.1f M msg/s (%.0f)\n", name, producers, consumers, messages / elapsed.count() / 1e6, sum);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 1)
+		messages = std::atol(argv[1]);
+
+	{
+		auto q = std::make_unique<mutex_queue>();
+		throughput("std::queue<std::any> + std::mutex", *q);
+	}
+	{
+		auto q = std::make_unique<spsc_queue<static_any<32>, 4096>>();
+		throughput("spsc_queue<static_any<32>, 4096>", *q);
+	}
+	{
+		auto q = std::make_unique<spsc_queue<static_any<32>, 4096, 64>>();
+		throughput("spsc_queue<static_any<32>, 4096, 64>", *q);
+	}
+
+	{
+		auto q = std::make_unique<mutex_queue>();
+		single_thread("std::queue<std::any> + std::mutex", *q);
+	}
+	{
+		auto q = std::make_unique<spsc_queue<static_any<32>, 4096>>();
+		single_thread("spsc_queue<static_any<32>, 4096>", *q);
+	}
+	{
+		auto q = std::make_unique<spsc_queue<static_any<32>, 4096, 64>>();
+		single_thread("spsc_queue<static_any<32>, 4096, 64>", *q);
+	}
+	{
+		auto q = std::make_unique<mpmc_queue<static_any<32>, 4096>>();
+		single_thread("mpmc_queue<static_any<32>, 4096>", *q);
+	}
+
+	const int threads = std::max(2, int(std::thread::hardware_concurrency()));
+	for (int n = 1; n <= threads / 2; n *= 2)
+	{
+		{
+			auto q = std::make_unique<mutex_queue>();
+			scaling("std::queue<std::any> + std::mutex", *q, n, n);
+		}
+		{
+			auto q = std::make_unique<mpmc_queue<static_any<32>, 4096>>();
+			scaling("mpmc_queue<static_any<32>, 4096>", *q, n, n);
+		}
+	}
+
+	{
+		auto ping = std::make_unique<mutex_queue>();
+		auto pong = std::make_unique<mutex_queue>();
+		latency("std::queue<std::any> + std::mutex", *ping, *pong);
+	}
+	{
+		auto ping = std::make_unique<spsc_queue<static_any<32>, 4096>>();
+		auto pong = std::make_unique<spsc_queue<static_any<32>, 4096>>();
+		latency("spsc_queue<static_any<32>, 4096>", *ping, *pong);
+	}
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include "any.hpp"
+
+#include <type_traits>
+#include <utility>
+
+namespace detail { namespace static_any {
+
+// the operations of _Interface for the values of type _T, one table per type as the function tables
+template <class _Interface, class _T>
+struct interface_table_for
+{
+	static constexpr _Interface value = _Interface::template make<_T>();
+};
+
+template <class _Interface, class _T>
+constexpr _Interface interface_table_for<_Interface, _T>::value;
+
+}}
+
+// A static_any<_N> whose values all implement the operations of _Interface, dispatched with a single indirect call,
+// without virtual inheritance nor allocation. _Interface is a table of function pointers, each taking the value as its
+// first parameter (void* or const void*), and fills it for a type _T with a constexpr static make<_T>():
+//
+//   struct Strategy
+//   {
+//       double (*apply)(void* self, double x);
+//       void (*print)(const void* self, std::ostream& os);
+//
+//       template <class _T>
+//       static constexpr Strategy make() { return { &apply_of<_T>, &print_of<_T> }; }
+//
+//       template <class _T>
+//       static double apply_of(void* self, double x) { return static_cast<_T*>(self)->apply(x); }
+//       ...
+//   };
+//
+//   interface_static_any<Strategy, 32> s = Scaled{2.};
+//   double y = s.call(&Strategy::apply, 1.5);
+//
+// The table of a type is set with its value, on assignment: the value and its table always match.
+template <class _Interface, std::size_t _N, std::size_t _Align = detail::static_any::default_alignment(_N)>
+class interface_static_any
+{
+	using access = detail::static_any::any_access;
+
+public:
+	template <class _T>
+	struct is_interface_static_any : public std::false_type {};
+
+	template <std::size_t _M, std::size_t _MAlign>
+	struct is_interface_static_any<interface_static_any<_Interface, _M, _MAlign>> : public std::true_type {};
+
+	using size_type = std::size_t;
+	using interface_type = _Interface;
+	using any_type = static_any<_N, _Align>;
+
+	static constexpr size_type capacity() { return _N; }
+	static constexpr size_type alignment() { return _Align; }
+
+	interface_static_any() = default;
+
+	template <class _T,
+			  class = std::enable_if_t<!is_interface_static_any<std::decay_t<_T>>::value>>
+	interface_static_any(_T&& t) :
+		__any(std::forward<_T>(t)),
+		__interface(interface_of<_T>())
+	{}
+
+	interface_static_any(const interface_static_any&) = default;
+
+	interface_static_any(interface_static_any&& another) noexcept :
+		__any(std::move(another.__any)),
+		__interface(another.__interface)
+	{
+		another.forget_moved_interface();
+	}
+
+	template <std::size_t _M, std::size_t _MAlign, class = std::enable_if_t<_M <= _N && _MAlign <= _Align>>
+	interface_static_any(const interface_static_any<_Interface, _M, _MAlign>& another) :
+		__any(another.__any),
+		__interface(another.__interface)
+	{}
+
+	template <std::size_t _M, std::size_t _MAlign, class = std::enable_if_t<_M <= _N && _MAlign <= _Align>>
+	interface_static_any(interface_static_any<_Interface, _M, _MAlign>&& another) :
+		__any(std::move(another.__any)),
+		__interface(another.__interface)
+	{
+		another.forget_moved_interface();
+	}
+
+	// the strong guarantee of static_any: if the assignment throws, the value and the table are unchanged
+	template <class _T,
+			  class = std::enable_if_t<!is_interface_static_any<std::decay_t<_T>>::value>>
+	interface_static_any& operator=(_T&& t)
+	{
+		__any = std::forward<_T>(t);
+		__interface = interface_of<_T>();
+		return *this;
+	}
+
+	interface_static_any& operator=(const interface_static_any& another)
+	{
+		__any = another.__any;
+		__interface = another.__interface;
+		return *this;
+	}
+
+	template <std::size_t _M, std::size_t _MAlign, class = std::enable_if_t<_M <= _N && _MAlign <= _Align>>
+	interface_static_any& operator=(const interface_static_any<_Interface, _M, _MAlign>& another)
+	{
+		__any = another.__any;
+		__interface = another.__interface;
+		return *this;
+	}
+
+	interface_static_any& operator=(interface_static_any&& another)
+	{
+		return assign_moved(another);
+	}
+
+	template <std::size_t _M, std::size_t _MAlign, class = std::enable_if_t<_M <= _N && _MAlign <= _Align>>
+	interface_static_any& operator=(interface_static_any<_Interface, _M, _MAlign>&& another)
+	{
+		return assign_moved(another);
+	}
+
+	// calls the operation op of the interface with the stored value and args; throws bad_any_cast if empty
+	template <class _R, class... Params, class... Args>
+	_R call(_R (*_Interface::*op)(void*, Params...), Args&&... args)
+	{
+		check();
+		return (__interface->*op)(access::data(__any), std::forward<Args>(args)...);
+	}
+
+	template <class _R, class... Params, class... Args>
+	_R call(_R (*_Interface::*op)(const void*, Params...), Args&&... args) const
+	{
+		check();
+		return (__interface->*op)(access::data(__any), std::forward<Args>(args)...);
+	}
+
+	// the table of the stored type, nullptr if empty
+	const _Interface* operations() const { return __interface; }
+
+	void reset()
+	{
+		__any.reset();
+		__interface = nullptr;
+	}
+
+	template <class _T, class... Args>
+	void emplace(Args&&... args)
+	{
+		__interface = nullptr;
+		__any.template emplace<_T>(std::forward<Args>(args)...);
+		__interface = interface_of<_T>();
+	}
+
+	template <class _T>
+	const _T& get() const { return __any.template get<_T>(); }
+
+	template <class _T>
+	_T& get() { return __any.template get<_T>(); }
+
+	template <class _T>
+	const _T* try_get() const noexcept { return __any.template try_get<_T>(); }
+
+	template <class _T>
+	_T* try_get() noexcept { return __any.template try_get<_T>(); }
+
+	template <class _T>
+	bool has() const { return __any.template has<_T>(); }
+
+	const std::type_info& type() const { return __any.type(); }
+
+	bool empty() const { return __any.empty(); }
+
+	size_type size() const { return __any.size(); }
+
+	const any_type& any() const { return __any; }
+
+private:
+	template <class _T>
+	static const _Interface* interface_of()
+	{
+		return &detail::static_any::interface_table_for<_Interface, std::remove_cv_t<std::remove_reference_t<_T>>>::value;
+	}
+
+	template <std::size_t _M, std::size_t _MAlign>
+	interface_static_any& assign_moved(interface_static_any<_Interface, _M, _MAlign>& another)
+	{
+		if (static_cast<const void*>(&another) == static_cast<const void*>(this))
+			return *this;
+
+		__any = std::move(another.__any);
+		__interface = another.__interface;
+		another.forget_moved_interface();
+		return *this;
+	}
+
+	// moving a trivially relocatable value leaves the source any empty: its table has to go with it
+	void forget_moved_interface()
+	{
+		if (__any.empty())
+			__interface = nullptr;
+	}
+
+	void check() const
+	{
+		if (__interface == nullptr)
+		{
+			detail::static_any::count(nullptr, detail::static_any::counter::bad_cast);
+			throw bad_any_cast(typeid(void), typeid(_Interface));
+		}
+	}
+
+	any_type __any;
+	const _Interface* __interface = nullptr;
+
+	template <class _I, std::size_t _M, std::size_t _MAlign>
+	friend class interface_static_any;
+};
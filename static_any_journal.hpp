@@ -0,0 +1,286 @@
+#pragma once
+
+#include "any.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+// A record of a journal: a static_any_t<_N> and the tag of the type of its value. The tag is the hash of the type
+// (see detail::static_any::type_hash), stable across processes built with the same compiler, unlike the indexes of
+// checked_static_any_t.
+template <std::size_t _N, std::size_t _Align = detail::static_any::default_alignment(_N)>
+struct journal_record
+{
+	using tag_type = detail::static_any::type_hash_t;
+
+	template <class _T>
+	static constexpr tag_type tag_of() { return detail::static_any::type_hash_v<_T>; }
+
+	template <class _T>
+	bool has() const { return tag == tag_of<_T>(); }
+
+	// the value has to be a _T, which is only asserted
+	template <class _T>
+	const _T& get() const
+	{
+		assert(has<_T>());
+		return value.template get<_T>();
+	}
+
+	tag_type tag;
+	static_any_t<_N, _Align> value;
+};
+
+namespace detail { namespace static_any {
+
+constexpr char journal_magic[8] = {'s', 't', 'a', 'n', 'y', 'j', 'r', 'n'};
+constexpr std::uint32_t journal_version = 1;
+
+// the records follow the header, at offset sizeof(journal_header)
+struct alignas(64) journal_header
+{
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t record_size;
+	std::uint64_t capacity;
+	std::atomic<std::uint64_t> size;
+};
+
+class journal_file
+{
+public:
+	journal_file(const std::string& path, int flags) :
+		__fd(::open(path.c_str(), flags | O_CLOEXEC, 0644))
+	{
+		if (__fd == -1)
+			throw std::system_error(errno, std::generic_category(), "cannot open journal " + path);
+	}
+
+	~journal_file()
+	{
+		if (__data != MAP_FAILED)
+			::munmap(__data, __length);
+		::close(__fd);
+	}
+
+	journal_file(const journal_file&) = delete;
+	journal_file& operator=(const journal_file&) = delete;
+
+	std::size_t file_size() const
+	{
+		struct stat st;
+		if (::fstat(__fd, &st) == -1)
+			throw std::system_error(errno, std::generic_category(), "cannot stat journal");
+		return static_cast<std::size_t>(st.st_size);
+	}
+
+	void resize(std::size_t length)
+	{
+		if (::ftruncate(__fd, static_cast<off_t>(length)) == -1)
+			throw std::system_error(errno, std::generic_category(), "cannot resize journal");
+	}
+
+	void map(std::size_t length, int protection)
+	{
+		__data = ::mmap(nullptr, length, protection, MAP_SHARED, __fd, 0);
+		if (__data == MAP_FAILED)
+			throw std::system_error(errno, std::generic_category(), "cannot map journal");
+		__length = length;
+	}
+
+	// writes back [begin, end) of the mapping, extended to whole pages
+	void sync(std::size_t begin, std::size_t end)
+	{
+		const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+		begin -= begin % page;
+		if (::msync(static_cast<char*>(__data) + begin, end - begin, MS_SYNC) == -1)
+			throw std::system_error(errno, std::generic_category(), "cannot sync journal");
+	}
+
+	void* data() const { return __data; }
+
+private:
+	int __fd;
+	void* __data = MAP_FAILED;
+	std::size_t __length = 0;
+};
+
+template <class _RecordT>
+void check_journal_header(const journal_header& header, std::size_t file_size)
+{
+	if (std::memcmp(header.magic, journal_magic, sizeof(journal_magic)) != 0 || header.version != journal_version)
+		throw std::runtime_error("not a static_any journal");
+	if (header.record_size != sizeof(_RecordT))
+		throw std::runtime_error("journal records of " + std::to_string(header.record_size) + " bytes, expected " +
+								 std::to_string(sizeof(_RecordT)));
+	if (file_size < sizeof(journal_header) + header.capacity * sizeof(_RecordT))
+		throw std::runtime_error("truncated journal");
+}
+
+}}
+
+// Appends records to a journal file, mapped in memory: the file is allocated for capacity records when created, and
+// appending is a copy to the mapping. An existing journal is appended to.
+//
+// Nothing is written to the disk explicitly by default, the kernel writing the dirty pages back on its own: the records
+// survive a crash of the process, but not of the machine. With sync_every > 0, the records are synced every sync_every
+// appends; sync() syncs the records not synced yet.
+//
+// The number of records is published in the header after each append: a journal_reader, even in another process, sees
+// the records as they are appended.
+template <std::size_t _N, std::size_t _Align = detail::static_any::default_alignment(_N)>
+class journal_writer
+{
+public:
+	using record_type = journal_record<_N, _Align>;
+	using size_type = std::size_t;
+
+	journal_writer(const std::string& path, size_type capacity, size_type sync_every = 0) :
+		__file(path, O_RDWR | O_CREAT),
+		__sync_every(sync_every)
+	{
+		using namespace detail::static_any;
+
+		const size_type file_size = __file.file_size();
+		if (file_size == 0)
+		{
+			__file.resize(sizeof(journal_header) + capacity * sizeof(record_type));
+			__file.map(sizeof(journal_header) + capacity * sizeof(record_type), PROT_READ | PROT_WRITE);
+
+			__header = new(__file.data()) journal_header{{}, journal_version, sizeof(record_type), capacity, {0}};
+			std::memcpy(__header->magic, journal_magic, sizeof(journal_magic));
+		}
+		else
+		{
+			if (file_size < sizeof(journal_header))
+				throw std::runtime_error("not a static_any journal");
+
+			__file.map(file_size, PROT_READ | PROT_WRITE);
+			__header = static_cast<journal_header*>(__file.data());
+			check_journal_header<record_type>(*__header, file_size);
+		}
+
+		__records = reinterpret_cast<record_type*>(__header + 1);
+		__size = __header->size.load(std::memory_order_relaxed);
+		__synced = __size;
+	}
+
+	~journal_writer()
+	{
+		if (__sync_every > 0)
+		{
+			try {
+				sync();
+			}
+			catch(...) {}
+		}
+	}
+
+	journal_writer(const journal_writer&) = delete;
+	journal_writer& operator=(const journal_writer&) = delete;
+
+	// returns false if the journal is full
+	template <class _T>
+	bool append(const _T& value)
+	{
+		if (__size == capacity())
+			return false;
+
+		record_type& record = __records[__size];
+		record.tag = record_type::template tag_of<_T>();
+		record.value = value;
+
+		__header->size.store(++__size, std::memory_order_release);
+
+		if (__sync_every > 0 && __size - __synced >= __sync_every)
+			sync();
+		return true;
+	}
+
+	void sync()
+	{
+		if (__synced == __size)
+			return;
+
+		// the records first, then the header publishing them: after a crash of the machine, the size never counts
+		// records that were not written back
+		__file.sync(offset(__synced), offset(__size));
+		__file.sync(0, sizeof(detail::static_any::journal_header));
+		__synced = __size;
+	}
+
+	size_type size() const { return __size; }
+	size_type capacity() const { return __header->capacity; }
+
+private:
+	static size_type offset(size_type record)
+	{
+		return sizeof(detail::static_any::journal_header) + record * sizeof(record_type);
+	}
+
+	detail::static_any::journal_file __file;
+	detail::static_any::journal_header* __header;
+	record_type* __records;
+	size_type __size;
+	size_type __synced;
+	size_type __sync_every;
+};
+
+// Reads a journal file in place, mapped in memory: iterating the journal iterates its records, without any copy. The
+// size is read from the header at each call, the records appended in the meantime by a writer being visible.
+template <std::size_t _N, std::size_t _Align = detail::static_any::default_alignment(_N)>
+class journal_reader
+{
+public:
+	using record_type = journal_record<_N, _Align>;
+	using size_type = std::size_t;
+	using const_iterator = const record_type*;
+
+	explicit journal_reader(const std::string& path) :
+		__file(path, O_RDONLY)
+	{
+		using namespace detail::static_any;
+
+		const size_type file_size = __file.file_size();
+		if (file_size < sizeof(journal_header))
+			throw std::runtime_error("not a static_any journal");
+
+		__file.map(file_size, PROT_READ);
+		__header = static_cast<const journal_header*>(__file.data());
+		check_journal_header<record_type>(*__header, file_size);
+
+		__records = reinterpret_cast<const record_type*>(__header + 1);
+	}
+
+	size_type size() const { return __header->size.load(std::memory_order_acquire); }
+	bool empty() const { return size() == 0; }
+	size_type capacity() const { return __header->capacity; }
+
+	const record_type& operator[](size_type i) const
+	{
+		assert(i < size());
+		return __records[i];
+	}
+
+	const_iterator begin() const { return __records; }
+	const_iterator end() const { return __records + size(); }
+
+private:
+	detail::static_any::journal_file __file;
+	const detail::static_any::journal_header* __header;
+	const record_type* __records;
+};
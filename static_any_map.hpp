@@ -0,0 +1,413 @@
+#pragma once
+
+#include "any.hpp"
+
+#include <memory>
+#include <utility>
+
+// An open addressing hash map keyed by static_any<_N>, e.g. to memoize results by heterogeneous arguments. Keys and
+// values are stored inline in a single array of slots, probed linearly. Each slot keeps the hash of its key: a probe
+// compares it, then the type header of the keys, and only then calls the equality of the type.
+//
+// Looking up a value of type _T, e.g. find(std::string("foo")), hashes and compares it directly, without storing it in
+// a static_any first; a key only matches values of the exact same type, an int is not found by a long. The types of
+// the keys must be supported by std::hash and equality comparable, or bad_any_hash / bad_any_comparison is thrown.
+// Inserting and erasing invalidate the pointers to the values.
+//
+// The entries are moved to a new table when it grows, and moved back when an entry is erased: the keys with the
+// noexcept move constructor of static_any, std::terminate being called if the move of a key throws, so that no
+// exception leaves a table half moved. An insertion that throws, e.g. std::bad_alloc or from the constructor of the
+// value, leaves the map unchanged, apart from its capacity; erase() and clear() do not throw.
+template <std::size_t _N, class _ValueT, std::size_t _Align = detail::static_any::default_alignment(_N)>
+class static_any_map
+{
+	// the entries are moved when the table grows
+	static_assert(std::is_nothrow_move_constructible<static_any<_N, _Align>>::value, "the keys must be nothrow move constructible");
+	static_assert(std::is_nothrow_move_constructible<_ValueT>::value, "_ValueT must be nothrow move constructible");
+
+public:
+	using key_type = static_any<_N, _Align>;
+	using mapped_type = _ValueT;
+	using size_type = std::size_t;
+
+	static_any_map() = default;
+
+	// room for at least size entries before the table grows
+	explicit static_any_map(size_type size);
+
+	static_any_map(const static_any_map& other);
+	static_any_map(static_any_map&& other) noexcept;
+	~static_any_map();
+
+	static_any_map& operator=(const static_any_map& other)
+	{
+		static_any_map temp(other);
+		return *this = std::move(temp);
+	}
+
+	static_any_map& operator=(static_any_map&& other) noexcept;
+
+	// nullptr if there is no such key; key is a static_any of any capacity, or a value
+	template <class _KeyT>
+	_ValueT* find(const _KeyT& key);
+
+	template <class _KeyT>
+	const _ValueT* find(const _KeyT& key) const;
+
+	template <class _KeyT>
+	bool contains(const _KeyT& key) const { return find(key) != nullptr; }
+
+	// constructs the value from args if there is no such key: returns the value, and true if it has been inserted
+	template <class _KeyT, class... Args>
+	std::pair<_ValueT*, bool> try_emplace(_KeyT&& key, Args&&... args);
+
+	template <class _KeyT>
+	_ValueT& operator[](_KeyT&& key) { return *try_emplace(std::forward<_KeyT>(key)).first; }
+
+	// returns true if the key has been erased
+	template <class _KeyT>
+	bool erase(const _KeyT& key);
+
+	// calls f(const key_type&, _ValueT&) for each entry, in no particular order
+	template <class _F>
+	void for_each(_F&& f);
+
+	template <class _F>
+	void for_each(_F&& f) const;
+
+	void reserve(size_type size);
+
+	void clear();
+
+	size_type size() const { return __size; }
+
+	bool empty() const { return __size == 0; }
+
+	size_type bucket_count() const { return __capacity; }
+
+private:
+	struct slot
+	{
+		_ValueT& value() { return *reinterpret_cast<_ValueT*>(__value); }
+		const _ValueT& value() const { return *reinterpret_cast<const _ValueT*>(__value); }
+
+		key_type key;
+		std::size_t hash = 0;
+		bool used = false;
+		alignas(_ValueT) char __value[sizeof(_ValueT)];
+	};
+
+	static constexpr size_type not_found = static_cast<size_type>(-1);
+
+	// a static_any is hashed and compared as such, any other key as the value of a static_any
+	template <std::size_t _M, std::size_t _MAlign>
+	static std::size_t hash_of(const static_any<_M, _MAlign>& key) { return std::hash<static_any<_M, _MAlign>>()(key); }
+
+	template <class _T>
+	static std::size_t hash_of(const _T& key) { return detail::static_any::hash_value(key); }
+
+	template <std::size_t _M, std::size_t _MAlign>
+	static bool matches(const key_type& k, const static_any<_M, _MAlign>& key) { return k == key; }
+
+	template <class _T>
+	static bool matches(const key_type& k, const _T& key)
+	{
+		const _T* t = k.template try_get<_T>();
+		return t != nullptr && *t == key;
+	}
+
+	// std::hash is the identity for integers: consecutive keys would fill runs of consecutive slots, the worst case of
+	// linear probing. The bits of the hash are mixed first, as by the finalizer of MurmurHash3
+	size_type home(std::size_t hash) const
+	{
+		constexpr unsigned half = sizeof(std::size_t) * 4;
+
+		hash ^= hash >> half;
+		hash *= static_cast<std::size_t>(0xff51afd7ed558ccdull);
+		hash ^= hash >> half;
+		return hash & (__capacity - 1);
+	}
+
+	// kept under 3/4 for the probe sequences to stay short
+	static bool is_overloaded(size_type size, size_type capacity) { return size * 4 > capacity * 3; }
+
+	template <class _KeyT>
+	size_type find_slot(const _KeyT& key, std::size_t hash) const;
+
+	size_type free_slot(std::size_t hash) const;
+
+	void rehash(size_type capacity);
+
+	void release(slot& s);
+
+	// moves the entry of from to the unused slot to
+	static void relocate(slot& to, slot& from) noexcept;
+
+	std::unique_ptr<slot[]> __slots;
+	size_type __capacity = 0;
+	size_type __size = 0;
+};
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+static_any_map<_N, _ValueT, _Align>::static_any_map(size_type size)
+{
+	reserve(size);
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+static_any_map<_N, _ValueT, _Align>::static_any_map(const static_any_map& other) :
+	static_any_map()
+{
+	if (other.__size == 0)
+		return;
+
+	// same capacity, so that each entry keeps its slot: the probe sequences are unchanged
+	__slots.reset(new slot[other.__capacity]);
+	__capacity = other.__capacity;
+
+	for (size_type i = 0; i < __capacity; ++i)
+	{
+		const slot& from = other.__slots[i];
+		if (!from.used)
+			continue;
+
+		slot& to = __slots[i];
+		to.key = from.key;
+		try {
+			new(to.__value) _ValueT(from.value());
+		}
+		catch(...) {
+			to.key.reset();
+			throw;
+		}
+
+		to.hash = from.hash;
+		to.used = true;
+		++__size;
+	}
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+static_any_map<_N, _ValueT, _Align>::static_any_map(static_any_map&& other) noexcept :
+	__slots(std::move(other.__slots)),
+	__capacity(other.__capacity),
+	__size(other.__size)
+{
+	other.__capacity = 0;
+	other.__size = 0;
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+static_any_map<_N, _ValueT, _Align>::~static_any_map()
+{
+	clear();
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+static_any_map<_N, _ValueT, _Align>& static_any_map<_N, _ValueT, _Align>::operator=(static_any_map&& other) noexcept
+{
+	if (&other == this)
+		return *this;
+
+	clear();
+	__slots = std::move(other.__slots);
+	__capacity = other.__capacity;
+	__size = other.__size;
+
+	other.__capacity = 0;
+	other.__size = 0;
+	return *this;
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+template <class _KeyT>
+_ValueT* static_any_map<_N, _ValueT, _Align>::find(const _KeyT& key)
+{
+	const auto& self = *this;
+	return const_cast<_ValueT*>(self.find(key));
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+template <class _KeyT>
+const _ValueT* static_any_map<_N, _ValueT, _Align>::find(const _KeyT& key) const
+{
+	if (__size == 0)
+		return nullptr;
+
+	const size_type i = find_slot(key, hash_of(key));
+	return i == not_found ? nullptr : &__slots[i].value();
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+template <class _KeyT, class... Args>
+std::pair<_ValueT*, bool> static_any_map<_N, _ValueT, _Align>::try_emplace(_KeyT&& key, Args&&... args)
+{
+	const std::size_t hash = hash_of(key);
+
+	if (__size != 0)
+	{
+		const size_type i = find_slot(key, hash);
+		if (i != not_found)
+			return {&__slots[i].value(), false};
+	}
+
+	if (is_overloaded(__size + 1, __capacity))
+		rehash(__capacity == 0 ? 16 : __capacity * 2);
+
+	slot& s = __slots[free_slot(hash)];
+	s.key = std::forward<_KeyT>(key);
+	try {
+		new(s.__value) _ValueT(std::forward<Args>(args)...);
+	}
+	catch(...) {
+		s.key.reset();
+		throw;
+	}
+
+	s.hash = hash;
+	s.used = true;
+	++__size;
+	return {&s.value(), true};
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+template <class _KeyT>
+bool static_any_map<_N, _ValueT, _Align>::erase(const _KeyT& key)
+{
+	if (__size == 0)
+		return false;
+
+	size_type i = find_slot(key, hash_of(key));
+	if (i == not_found)
+		return false;
+
+	release(__slots[i]);
+	--__size;
+
+	// backward shift: the entries following i in its probe sequence, that could have been stored at i, are moved back,
+	// so that no probe stops early on the hole
+	const size_type mask = __capacity - 1;
+	for (size_type j = (i + 1) & mask; __slots[j].used; j = (j + 1) & mask)
+	{
+		const size_type k = home(__slots[j].hash);
+		const bool reachable = i <= j ? (k <= i || k > j) : (k <= i && k > j);
+		if (reachable)
+		{
+			relocate(__slots[i], __slots[j]);
+			i = j;
+		}
+	}
+
+	return true;
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+template <class _F>
+void static_any_map<_N, _ValueT, _Align>::for_each(_F&& f)
+{
+	for (size_type i = 0; i < __capacity; ++i)
+		if (__slots[i].used)
+			f(static_cast<const key_type&>(__slots[i].key), __slots[i].value());
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+template <class _F>
+void static_any_map<_N, _ValueT, _Align>::for_each(_F&& f) const
+{
+	for (size_type i = 0; i < __capacity; ++i)
+		if (__slots[i].used)
+			f(static_cast<const key_type&>(__slots[i].key), static_cast<const _ValueT&>(__slots[i].value()));
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+void static_any_map<_N, _ValueT, _Align>::reserve(size_type size)
+{
+	size_type capacity = __capacity == 0 ? 16 : __capacity;
+	while (is_overloaded(size, capacity))
+		capacity *= 2;
+
+	if (capacity != __capacity)
+		rehash(capacity);
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+void static_any_map<_N, _ValueT, _Align>::clear()
+{
+	for (size_type i = 0; __size != 0 && i < __capacity; ++i)
+	{
+		if (__slots[i].used)
+		{
+			release(__slots[i]);
+			--__size;
+		}
+	}
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+template <class _KeyT>
+typename static_any_map<_N, _ValueT, _Align>::size_type static_any_map<_N, _ValueT, _Align>::find_slot(const _KeyT& key, std::size_t hash) const
+{
+	assert(__capacity != 0);
+
+	// terminates: the table is never full
+	const size_type mask = __capacity - 1;
+	for (size_type i = home(hash); __slots[i].used; i = (i + 1) & mask)
+		if (__slots[i].hash == hash && matches(__slots[i].key, key))
+			return i;
+
+	return not_found;
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+typename static_any_map<_N, _ValueT, _Align>::size_type static_any_map<_N, _ValueT, _Align>::free_slot(std::size_t hash) const
+{
+	const size_type mask = __capacity - 1;
+
+	size_type i = home(hash);
+	while (__slots[i].used)
+		i = (i + 1) & mask;
+	return i;
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+void static_any_map<_N, _ValueT, _Align>::rehash(size_type capacity)
+{
+	assert((capacity & (capacity - 1)) == 0);
+
+	std::unique_ptr<slot[]> slots(new slot[capacity]);
+	std::swap(__slots, slots);
+
+	const size_type old_capacity = __capacity;
+	__capacity = capacity;
+
+	for (size_type i = 0; i < old_capacity; ++i)
+		if (slots[i].used)
+			relocate(__slots[free_slot(slots[i].hash)], slots[i]);
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+void static_any_map<_N, _ValueT, _Align>::release(slot& s)
+{
+	assert(s.used);
+
+	s.value().~_ValueT();
+	s.key.reset();
+	s.used = false;
+}
+
+template <std::size_t _N, class _ValueT, std::size_t _Align>
+void static_any_map<_N, _ValueT, _Align>::relocate(slot& to, slot& from) noexcept
+{
+	assert(!to.used && from.used);
+
+	// move constructed, not assigned: the assignment of static_any throws if the move of the value does
+	to.key.~key_type();
+	new(&to.key) key_type(std::move(from.key));
+	new(to.__value) _ValueT(std::move(from.value()));
+	to.hash = from.hash;
+	to.used = true;
+
+	from.value().~_ValueT();
+	from.key.reset();
+	from.used = false;
+}
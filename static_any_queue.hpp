@@ -0,0 +1,340 @@
+#pragma once
+
+#include "any.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace detail { namespace static_any {
+
+constexpr std::size_t cache_line_size = 64;
+
+template <class _AnyT>
+auto reset_slot(_AnyT& any, int) -> decltype(any.reset())
+{
+	any.reset();
+}
+
+// static_any_t: nothing to destroy
+template <class _AnyT>
+void reset_slot(_AnyT&, long)
+{}
+
+template <class _AnyT>
+void reset_slot(_AnyT& any)
+{
+	reset_slot(any, 0);
+}
+
+template <class _AnyT, class = void>
+struct has_empty_state : std::false_type {};
+
+template <class _AnyT>
+struct has_empty_state<_AnyT, decltype(void(std::declval<const _AnyT&>().empty()))> : std::true_type {};
+
+}}
+
+// A bounded single-producer single-consumer queue of anys, e.g. static_any<_N> or static_any_t<_N>. The values are
+// constructed in place in a ring of _Capacity slots: pushing and consuming never allocate.
+//
+// Each side owns a cache line holding its position and a copy of the position of the other side, only refreshed
+// when the ring looks full (or empty): in the steady state, the producer and the consumer only share the slots.
+// Positions are published every _Batch operations, and whenever the ring is found full (or empty). With _Batch > 1,
+// the producer has to flush() when it runs out of messages for the consumer to see the last ones.
+template <class _AnyT, std::size_t _Capacity, std::size_t _Batch = 1>
+class spsc_queue
+{
+	static_assert(_Capacity > 0 && (_Capacity & (_Capacity - 1)) == 0, "_Capacity must be a power of two");
+	static_assert(_Batch > 0 && _Batch <= _Capacity, "_Batch must be in [1, _Capacity]");
+
+	static constexpr std::size_t cache_line_size = detail::static_any::cache_line_size;
+
+public:
+	using value_type = _AnyT;
+	using size_type = std::size_t;
+
+	static constexpr size_type capacity() { return _Capacity; }
+
+	spsc_queue() = default;
+	spsc_queue(const spsc_queue&) = delete;
+	spsc_queue& operator=(const spsc_queue&) = delete;
+
+	// Producer: constructs a _ValueT from args in the next slot, returns false if the queue is full
+	template <class _ValueT, class... Args>
+	bool try_emplace(Args&&... args)
+	{
+		_AnyT* slot = next_free_slot();
+		if (slot == nullptr)
+			return false;
+
+		slot->template emplace<_ValueT>(std::forward<Args>(args)...);
+		commit_push();
+		return true;
+	}
+
+	// Producer: pushes a value, or the content of an any, returns false if the queue is full
+	template <class _ValueT>
+	bool try_push(_ValueT&& value)
+	{
+		_AnyT* slot = next_free_slot();
+		if (slot == nullptr)
+			return false;
+
+		*slot = std::forward<_ValueT>(value);
+		commit_push();
+		return true;
+	}
+
+	// Producer: publishes the values pushed since the last publication
+	void flush()
+	{
+		__producer.position.store(__producer.pending, std::memory_order_release);
+	}
+
+	// Consumer: calls visitor(_AnyT&) with the oldest value, in place, and destroys it afterwards. Returns false if
+	// the queue is empty
+	template <class _VisitorT>
+	bool try_consume(_VisitorT&& visitor)
+	{
+		_AnyT* slot = next_used_slot();
+		if (slot == nullptr)
+			return false;
+
+		struct commit_guard
+		{
+			~commit_guard() { queue.commit_pop(*slot); }
+
+			spsc_queue& queue;
+			_AnyT* slot;
+		} guard{*this, slot};
+
+		std::forward<_VisitorT>(visitor)(*slot);
+		return true;
+	}
+
+	// Consumer: moves the oldest value to any, returns false if the queue is empty
+	bool try_pop(_AnyT& any)
+	{
+		return try_consume([&any](_AnyT& slot) { any = std::move(slot); });
+	}
+
+	// Consumer: true if there is no published value to consume
+	bool empty() const
+	{
+		return __consumer.pending == __producer.position.load(std::memory_order_acquire);
+	}
+
+private:
+	_AnyT* next_free_slot()
+	{
+		if (__producer.pending - __producer.cached == _Capacity)
+		{
+			flush();
+
+			__producer.cached = __consumer.position.load(std::memory_order_acquire);
+			if (__producer.pending - __producer.cached == _Capacity)
+				return nullptr;
+		}
+
+		return &__slots[__producer.pending & (_Capacity - 1)];
+	}
+
+	void commit_push()
+	{
+		++__producer.pending;
+		if (__producer.pending - __producer.position.load(std::memory_order_relaxed) >= _Batch)
+			flush();
+	}
+
+	_AnyT* next_used_slot()
+	{
+		if (__consumer.pending == __consumer.cached)
+		{
+			__consumer.position.store(__consumer.pending, std::memory_order_release);
+
+			__consumer.cached = __producer.position.load(std::memory_order_acquire);
+			if (__consumer.pending == __consumer.cached)
+				return nullptr;
+		}
+
+		return &__slots[__consumer.pending & (_Capacity - 1)];
+	}
+
+	void commit_pop(_AnyT& slot)
+	{
+		detail::static_any::reset_slot(slot);
+
+		++__consumer.pending;
+		if (__consumer.pending - __consumer.position.load(std::memory_order_relaxed) >= _Batch)
+			__consumer.position.store(__consumer.pending, std::memory_order_release);
+	}
+
+	// position: published, read by the other side; pending: position of the next operation; cached: last position
+	// read from the other side. Only position is shared, the other members being on their own cache line
+	struct side
+	{
+		alignas(cache_line_size) std::atomic<size_type> position{0};
+		alignas(cache_line_size) size_type pending = 0;
+		size_type cached = 0;
+	};
+
+	side __producer;
+	side __consumer;
+	alignas(cache_line_size) _AnyT __slots[_Capacity];
+};
+
+// A bounded multi-producer multi-consumer queue of anys, constructed in place in a ring of _Capacity cells: pushing
+// and consuming never allocate. Each cell has its own cache line and a sequence number telling whether it is free
+// for the push at a given position, or ready for the pop at that position: producers (consumers) only contend on
+// the position they claim with a CAS, the values being constructed and destroyed outside of any critical section.
+//
+// If the construction of a value throws, its cell is released empty and flagged so that consumers skip it: the any type
+// needs an empty state (static_any, compact_static_any...), unless the construction cannot throw. Empty anys pushed
+// on purpose are consumed as any other value.
+template <class _AnyT, std::size_t _Capacity>
+class mpmc_queue
+{
+	static_assert(_Capacity > 1 && (_Capacity & (_Capacity - 1)) == 0, "_Capacity must be a power of two");
+
+	static constexpr std::size_t cache_line_size = detail::static_any::cache_line_size;
+
+public:
+	using value_type = _AnyT;
+	using size_type = std::size_t;
+
+	static constexpr size_type capacity() { return _Capacity; }
+
+	mpmc_queue()
+	{
+		for (size_type i = 0; i < _Capacity; ++i)
+			__cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	mpmc_queue(const mpmc_queue&) = delete;
+	mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+	// Constructs a _ValueT from args in the next cell, returns false if the queue is full
+	template <class _ValueT, class... Args>
+	bool try_emplace(Args&&... args)
+	{
+		static_assert(detail::static_any::has_empty_state<_AnyT>::value || std::is_nothrow_constructible<_ValueT, Args...>::value,
+					  "the construction of _ValueT can throw, but _AnyT cannot be left empty");
+
+		size_type position;
+		cell* c = claim(__push_position, 0, position);
+		if (c == nullptr)
+			return false;
+
+		push_guard guard{c, position};
+		c->value.template emplace<_ValueT>(std::forward<Args>(args)...);
+		guard.constructed = true;
+		return true;
+	}
+
+	// Pushes a value, or the content of an any, returns false if the queue is full
+	template <class _ValueT>
+	bool try_push(_ValueT&& value)
+	{
+		size_type position;
+		cell* c = claim(__push_position, 0, position);
+		if (c == nullptr)
+			return false;
+
+		push_guard guard{c, position};
+		c->value = std::forward<_ValueT>(value);
+		guard.constructed = true;
+		return true;
+	}
+
+	// Calls visitor(_AnyT&) with the oldest value, in place, and destroys it afterwards. Returns false if the queue is
+	// empty
+	template <class _VisitorT>
+	bool try_consume(_VisitorT&& visitor)
+	{
+		for (;;)
+		{
+			size_type position;
+			cell* c = claim(__pop_position, 1, position);
+			if (c == nullptr)
+				return false;
+
+			pop_guard guard{c, position};
+			if (c->constructed)
+			{
+				std::forward<_VisitorT>(visitor)(c->value);
+				return true;
+			}
+		}
+	}
+
+	// Moves the oldest value to any, returns false if the queue is empty
+	bool try_pop(_AnyT& any)
+	{
+		return try_consume([&any](_AnyT& value) { any = std::move(value); });
+	}
+
+private:
+	struct alignas(cache_line_size) cell
+	{
+		std::atomic<size_type> sequence;
+		bool constructed = false; // false if the construction of the value threw, published by sequence
+		_AnyT value;
+	};
+
+	// cell of the push (pop) at the next position, whose sequence is position + offset when it is ready
+	cell* claim(std::atomic<size_type>& next, size_type offset, size_type& position)
+	{
+		position = next.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell& c = __cells[position & (_Capacity - 1)];
+			const size_type sequence = c.sequence.load(std::memory_order_acquire);
+			const auto diff = static_cast<std::ptrdiff_t>(sequence - (position + offset));
+
+			if (diff == 0)
+			{
+				if (next.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					return &c;
+			}
+			else if (diff < 0)
+			{
+				return nullptr;
+			}
+			else
+			{
+				position = next.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	struct push_guard
+	{
+		~push_guard()
+		{
+			c->constructed = constructed;
+			c->sequence.store(position + 1, std::memory_order_release);
+		}
+
+		cell* c;
+		size_type position;
+		bool constructed = false;
+	};
+
+	struct pop_guard
+	{
+		~pop_guard()
+		{
+			detail::static_any::reset_slot(c->value);
+			c->sequence.store(position + _Capacity, std::memory_order_release);
+		}
+
+		cell* c;
+		size_type position;
+	};
+
+	alignas(cache_line_size) std::atomic<size_type> __push_position{0};
+	alignas(cache_line_size) std::atomic<size_type> __pop_position{0};
+	cell __cells[_Capacity];
+};
@@ -0,0 +1,468 @@
+#pragma once
+
+#include "any.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// A heterogeneous container of values of up to _N bytes, like a std::vector<static_any<_N>>, but storing the
+// values grouped by type: each type has its own segment, a contiguous array of values of that type. Iterating
+// over the values of one type costs a single type dispatch per segment instead of a type check per element,
+// and the loop body works on a plain array of _T.
+//
+// The insertion order is lost, unless _KeepOrder is set: an index of (segment, position) is then maintained,
+// giving access to the i-th inserted value.
+template <std::size_t _N, bool _KeepOrder = false>
+class static_any_vector
+{
+	using function_table_ptr_t = detail::static_any::function_table_ptr_t;
+
+	class segment
+	{
+	public:
+		explicit segment(function_table_ptr_t function) :
+			__function(function)
+		{}
+
+		segment(const segment& other);
+		segment(segment&& other) noexcept;
+		~segment();
+
+		segment& operator=(const segment&) = delete;
+		segment& operator=(segment&&) = delete;
+
+		function_table_ptr_t function() const { return __function; }
+		std::size_t size() const { return __size; }
+
+		void* data() { return __data.get(); }
+		const void* data() const { return __data.get(); }
+
+		void* at(std::size_t i) { return __data.get() + i * __function->size; }
+		const void* at(std::size_t i) const { return __data.get() + i * __function->size; }
+
+		// returns the uninitialized storage of the next element, which is only accounted for after commit()
+		void* prepare_back();
+		void commit_back() { ++__size; }
+
+		void clear();
+
+	private:
+		void relocate_to(char* data);
+
+		function_table_ptr_t __function;
+		std::unique_ptr<char[]> __data;
+		std::size_t __size = 0;
+		std::size_t __capacity = 0;
+	};
+
+	struct position
+	{
+		std::uint32_t segment;
+		std::uint32_t index;
+	};
+
+public:
+	using size_type = std::size_t;
+
+	static constexpr size_type capacity() { return _N; }
+
+	static_any_vector() = default;
+	static_any_vector(const static_any_vector&) = default;
+
+	// the moved-from vector is empty
+	static_any_vector(static_any_vector&& other) noexcept :
+		__segments(std::move(other.__segments)),
+		__order(std::move(other.__order)),
+		__size(other.__size)
+	{
+		other.clear();
+	}
+
+	static_any_vector& operator=(const static_any_vector& other)
+	{
+		static_any_vector temp(other);
+		return *this = std::move(temp);
+	}
+
+	static_any_vector& operator=(static_any_vector&& other) noexcept
+	{
+		if (&other != this)
+		{
+			__segments = std::move(other.__segments);
+			__order = std::move(other.__order);
+			__size = other.__size;
+			other.clear();
+		}
+		return *this;
+	}
+
+	template <class _T>
+	void push_back(_T&& t)
+	{
+		emplace_back<std::remove_cv_t<std::remove_reference_t<_T>>>(std::forward<_T>(t));
+	}
+
+	template <class _T, class... Args>
+	_T& emplace_back(Args&&... args);
+
+	// calls f(_T&) for each value of type _T, in insertion order among the values of type _T
+	template <class _T, class _F>
+	void for_each(_F&& f);
+
+	template <class _T, class _F>
+	void for_each(_F&& f) const;
+
+	// calls f(T&) for each value whose type T is one of _Ts, segment by segment
+	template <class... _Ts, class _F>
+	void visit(_F&& f);
+
+	template <class... _Ts, class _F>
+	void visit(_F&& f) const;
+
+	// contiguous values of type _T, count<_T>() of them
+	template <class _T>
+	_T* data();
+
+	template <class _T>
+	const _T* data() const;
+
+	template <class _T>
+	size_type count() const;
+
+	size_type size() const { return __size; }
+
+	bool empty() const { return __size == 0; }
+
+	void clear();
+
+	// access by insertion order, only available if _KeepOrder is set
+	const std::type_info& type(size_type i) const;
+
+	template <class _T>
+	bool has(size_type i) const;
+
+	template <class _T>
+	_T& get(size_type i);
+
+	template <class _T>
+	const _T& get(size_type i) const;
+
+private:
+	template <class _T>
+	segment* find_segment();
+
+	template <class _T>
+	const segment* find_segment() const;
+
+	template <class _T>
+	std::size_t find_or_add_segment();
+
+	template <class _T, class _F, class _SegmentT>
+	static void for_each_in_segment(_SegmentT& seg, _F& f);
+
+	template <class _F, class _SegmentT>
+	static void visit_segment(_SegmentT&, _F&) {}
+
+	template <class _F, class _SegmentT, class _T, class... _Ts>
+	static void visit_segment(_SegmentT& seg, _F& f);
+
+	const position& position_of(size_type i) const;
+
+	std::vector<segment> __segments;
+	std::vector<position> __order;
+	size_type __size = 0;
+};
+
+template <std::size_t _N, bool _KeepOrder>
+static_any_vector<_N, _KeepOrder>::segment::segment(const segment& other) :
+	__function(other.__function)
+{
+	if (other.__size == 0)
+		return;
+
+	__data.reset(new char[other.__size * __function->size]);
+	__capacity = other.__size;
+
+	if (__function->trivial)
+	{
+		std::memcpy(__data.get(), other.__data.get(), other.__size * __function->size);
+		__size = other.__size;
+		return;
+	}
+
+	try {
+		for (; __size < other.__size; ++__size)
+			__function->copy(at(__size), other.at(__size));
+	}
+	catch(...) {
+		clear();
+		throw;
+	}
+}
+
+template <std::size_t _N, bool _KeepOrder>
+static_any_vector<_N, _KeepOrder>::segment::segment(segment&& other) noexcept :
+	__function(other.__function),
+	__data(std::move(other.__data)),
+	__size(other.__size),
+	__capacity(other.__capacity)
+{
+	other.__size = 0;
+	other.__capacity = 0;
+}
+
+template <std::size_t _N, bool _KeepOrder>
+static_any_vector<_N, _KeepOrder>::segment::~segment()
+{
+	clear();
+}
+
+template <std::size_t _N, bool _KeepOrder>
+void* static_any_vector<_N, _KeepOrder>::segment::prepare_back()
+{
+	if (__size == __capacity)
+	{
+		const std::size_t capacity = __capacity == 0 ? 4 : __capacity * 2;
+		std::unique_ptr<char[]> data(new char[capacity * __function->size]);
+
+		relocate_to(data.get());
+		__data = std::move(data);
+		__capacity = capacity;
+	}
+
+	return at(__size);
+}
+
+template <std::size_t _N, bool _KeepOrder>
+void static_any_vector<_N, _KeepOrder>::segment::relocate_to(char* data)
+{
+	const std::size_t size = __function->size;
+
+	if (__function->relocatable)
+	{
+		if (__size != 0)
+			std::memcpy(data, __data.get(), __size * size);
+		return;
+	}
+
+	// same as std::vector: moving only if it cannot throw (or if there is no other choice) keeps the old
+	// elements intact in case of exception
+	const bool move = __function->nothrow_move || !__function->copyable;
+
+	std::size_t i = 0;
+	try {
+		for (; i < __size; ++i)
+		{
+			if (move)
+				__function->move(data + i * size, at(i));
+			else
+				__function->copy(data + i * size, at(i));
+		}
+	}
+	catch(...) {
+		while (i > 0)
+			__function->destroy(data + --i * size);
+		throw;
+	}
+
+	for (i = 0; i < __size; ++i)
+		__function->destroy(at(i));
+}
+
+template <std::size_t _N, bool _KeepOrder>
+void static_any_vector<_N, _KeepOrder>::segment::clear()
+{
+	if (!__function->trivial)
+	{
+		for (std::size_t i = 0; i < __size; ++i)
+			__function->destroy(at(i));
+	}
+	__size = 0;
+}
+
+template <std::size_t _N, bool _KeepOrder>
+template <class _T, class... Args>
+_T& static_any_vector<_N, _KeepOrder>::emplace_back(Args&&... args)
+{
+	static_assert(capacity() >= sizeof(_T), "_T is too big to be copied to static_any_vector");
+	static_assert(alignof(std::max_align_t) >= alignof(_T), "_T is too aligned to be copied to static_any_vector");
+
+	const std::size_t seg = find_or_add_segment<_T>();
+	segment& s = __segments[seg];
+
+	if (_KeepOrder)
+		__order.push_back(position{static_cast<std::uint32_t>(seg), static_cast<std::uint32_t>(s.size())});
+
+	_T* t;
+	try {
+		t = new(s.prepare_back()) _T(std::forward<Args>(args)...);
+	}
+	catch(...) {
+		if (_KeepOrder)
+			__order.pop_back();
+		throw;
+	}
+
+	s.commit_back();
+	++__size;
+
+	return *t;
+}
+
+template <std::size_t _N, bool _KeepOrder>
+template <class _T, class _F>
+void static_any_vector<_N, _KeepOrder>::for_each(_F&& f)
+{
+	if (segment* seg = find_segment<_T>())
+		for_each_in_segment<_T>(*seg, f);
+}
+
+template <std::size_t _N, bool _KeepOrder>
+template <class _T, class _F>
+void static_any_vector<_N, _KeepOrder>::for_each(_F&& f) const
+{
+	if (const segment* seg = find_segment<_T>())
+		for_each_in_segment<const _T>(*seg, f);
+}
+
+template <std::size_t _N, bool _KeepOrder>
+template <class... _Ts, class _F>
+void static_any_vector<_N, _KeepOrder>::visit(_F&& f)
+{
+	for (segment& seg : __segments)
+		visit_segment<_F, segment, _Ts...>(seg, f);
+}
+
+template <std::size_t _N, bool _KeepOrder>
+template <class... _Ts, class _F>
+void static_any_vector<_N, _KeepOrder>::visit(_F&& f) const
+{
+	for (const segment& seg : __segments)
+		visit_segment<_F, const segment, const _Ts...>(seg, f);
+}
+
+template <std::size_t _N, bool _KeepOrder>
+template <class _T>
+_T* static_any_vector<_N, _KeepOrder>::data()
+{
+	segment* seg = find_segment<_T>();
+	return seg ? static_cast<_T*>(seg->data()) : nullptr;
+}
+
+template <std::size_t _N, bool _KeepOrder>
+template <class _T>
+const _T* static_any_vector<_N, _KeepOrder>::data() const
+{
+	const segment* seg = find_segment<_T>();
+	return seg ? static_cast<const _T*>(seg->data()) : nullptr;
+}
+
+template <std::size_t _N, bool _KeepOrder>
+template <class _T>
+typename static_any_vector<_N, _KeepOrder>::size_type static_any_vector<_N, _KeepOrder>::count() const
+{
+	const segment* seg = find_segment<_T>();
+	return seg ? seg->size() : 0;
+}
+
+template <std::size_t _N, bool _KeepOrder>
+void static_any_vector<_N, _KeepOrder>::clear()
+{
+	__segments.clear();
+	__order.clear();
+	__size = 0;
+}
+
+template <std::size_t _N, bool _KeepOrder>
+const std::type_info& static_any_vector<_N, _KeepOrder>::type(size_type i) const
+{
+	return *__segments[position_of(i).segment].function()->type;
+}
+
+template <std::size_t _N, bool _KeepOrder>
+template <class _T>
+bool static_any_vector<_N, _KeepOrder>::has(size_type i) const
+{
+	return detail::static_any::is_function_for_type<_T>(__segments[position_of(i).segment].function());
+}
+
+template <std::size_t _N, bool _KeepOrder>
+template <class _T>
+_T& static_any_vector<_N, _KeepOrder>::get(size_type i)
+{
+	const auto& self = *this;
+	return const_cast<_T&>(self.template get<_T>(i));
+}
+
+template <std::size_t _N, bool _KeepOrder>
+template <class _T>
+const _T& static_any_vector<_N, _KeepOrder>::get(size_type i) const
+{
+	const position& pos = position_of(i);
+	const segment& seg = __segments[pos.segment];
+
+	if (!detail::static_any::is_function_for_type<_T>(seg.function()))
+		throw bad_any_cast(*seg.function()->type, typeid(_T));
+
+	return *static_cast<const _T*>(seg.at(pos.index));
+}
+
+template <std::size_t _N, bool _KeepOrder>
+template <class _T>
+typename static_any_vector<_N, _KeepOrder>::segment* static_any_vector<_N, _KeepOrder>::find_segment()
+{
+	for (segment& seg : __segments)
+		if (detail::static_any::is_function_for_type<_T>(seg.function()))
+			return &seg;
+	return nullptr;
+}
+
+template <std::size_t _N, bool _KeepOrder>
+template <class _T>
+const typename static_any_vector<_N, _KeepOrder>::segment* static_any_vector<_N, _KeepOrder>::find_segment() const
+{
+	return const_cast<static_any_vector*>(this)->template find_segment<_T>();
+}
+
+template <std::size_t _N, bool _KeepOrder>
+template <class _T>
+std::size_t static_any_vector<_N, _KeepOrder>::find_or_add_segment()
+{
+	for (std::size_t i = 0; i < __segments.size(); ++i)
+		if (detail::static_any::is_function_for_type<_T>(__segments[i].function()))
+			return i;
+
+	__segments.emplace_back(detail::static_any::get_function_for_type<_T>());
+	return __segments.size() - 1;
+}
+
+template <std::size_t _N, bool _KeepOrder>
+template <class _T, class _F, class _SegmentT>
+void static_any_vector<_N, _KeepOrder>::for_each_in_segment(_SegmentT& seg, _F& f)
+{
+	_T* first = static_cast<_T*>(seg.data());
+	_T* last = first + seg.size();
+
+	for (; first != last; ++first)
+		f(*first);
+}
+
+template <std::size_t _N, bool _KeepOrder>
+template <class _F, class _SegmentT, class _T, class... _Ts>
+void static_any_vector<_N, _KeepOrder>::visit_segment(_SegmentT& seg, _F& f)
+{
+	if (detail::static_any::is_function_for_type<_T>(seg.function()))
+		for_each_in_segment<_T>(seg, f);
+	else
+		visit_segment<_F, _SegmentT, _Ts...>(seg, f);
+}
+
+template <std::size_t _N, bool _KeepOrder>
+const typename static_any_vector<_N, _KeepOrder>::position& static_any_vector<_N, _KeepOrder>::position_of(size_type i) const
+{
+	static_assert(_KeepOrder, "access by insertion order requires static_any_vector<_N, true>");
+	assert(i < __order.size());
+	return __order[i];
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+#include "any.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace detail { namespace static_any {
+
+template <class _R, class _F, class... Args>
+_R invoke_as(std::false_type, _F& f, Args&&... args)
+{
+	return f(std::forward<Args>(args)...);
+}
+
+// void signature: the result of the callable, if any, is discarded
+template <class _R, class _F, class... Args>
+_R invoke_as(std::true_type, _F& f, Args&&... args)
+{
+	f(std::forward<Args>(args)...);
+}
+
+}}
+
+template <class _Sig, std::size_t _N = 32, std::size_t _Align = detail::static_any::default_alignment(_N)>
+class static_function;
+
+// A callable stored in place, like a std::function that never allocates: the callable is stored in a buffer of _N bytes
+// and copied, moved and destroyed through the function table of static_any, its size being checked at compile time. The
+// pointer to the invoker of the callable is stored next to the buffer, so a call is a single indirect call -- including
+// on an empty static_function, whose invoker throws std::bad_function_call.
+//
+// Move only callables are supported: copying a static_function storing one throws bad_any_copy.
+template <class _R, class... Args, std::size_t _N, std::size_t _Align>
+class static_function<_R(Args...), _N, _Align>
+{
+	using function_table_ptr_t = detail::static_any::function_table_ptr_t;
+	using invoker_t = _R (*)(void*, Args&&...);
+
+public:
+	template <class _T>
+	struct is_static_function : public std::false_type {};
+
+	template <std::size_t _M, std::size_t _MAlign>
+	struct is_static_function<static_function<_R(Args...), _M, _MAlign>> : public std::true_type {};
+
+	using result_type = _R;
+	using size_type = std::size_t;
+
+	static constexpr size_type capacity() { return _N; }
+	static constexpr size_type alignment() { return _Align; }
+
+	static_function() = default;
+
+	static_function(std::nullptr_t) {}
+
+	template <class _F,
+			  class = std::enable_if_t<!is_static_function<std::decay_t<_F>>::value && !std::is_same<std::decay_t<_F>, std::nullptr_t>::value>>
+	static_function(_F&& f)
+	{
+		construct(std::forward<_F>(f));
+	}
+
+	static_function(const static_function& other)
+	{
+		construct_from(other, detail::static_any::copy_tag{});
+	}
+
+	// as the move of static_any, calls std::terminate if the move of the callable throws: a std::vector of
+	// static_functions moves them when it grows, including the move only ones
+	static_function(static_function&& other) noexcept
+	{
+		construct_from(other, detail::static_any::move_tag{});
+	}
+
+	template <std::size_t _M, std::size_t _MAlign, class = std::enable_if_t<_M <= _N && _MAlign <= _Align>>
+	static_function(const static_function<_R(Args...), _M, _MAlign>& other)
+	{
+		construct_from(other, detail::static_any::copy_tag{});
+	}
+
+	template <std::size_t _M, std::size_t _MAlign, class = std::enable_if_t<_M <= _N && _MAlign <= _Align>>
+	static_function(static_function<_R(Args...), _M, _MAlign>&& other) noexcept
+	{
+		construct_from(other, detail::static_any::move_tag{});
+	}
+
+	~static_function() { destroy(); }
+
+	// if the construction of the new callable throws, *this is left empty
+	static_function& operator=(const static_function& other)
+	{
+		assign_from(other, detail::static_any::copy_tag{});
+		return *this;
+	}
+
+	static_function& operator=(static_function&& other) noexcept
+	{
+		assign_from(other, detail::static_any::move_tag{});
+		return *this;
+	}
+
+	template <std::size_t _M, std::size_t _MAlign, class = std::enable_if_t<_M <= _N && _MAlign <= _Align>>
+	static_function& operator=(const static_function<_R(Args...), _M, _MAlign>& other)
+	{
+		assign_from(other, detail::static_any::copy_tag{});
+		return *this;
+	}
+
+	template <std::size_t _M, std::size_t _MAlign, class = std::enable_if_t<_M <= _N && _MAlign <= _Align>>
+	static_function& operator=(static_function<_R(Args...), _M, _MAlign>&& other) noexcept
+	{
+		assign_from(other, detail::static_any::move_tag{});
+		return *this;
+	}
+
+	static_function& operator=(std::nullptr_t)
+	{
+		destroy();
+		return *this;
+	}
+
+	template <class _F,
+			  class = std::enable_if_t<!is_static_function<std::decay_t<_F>>::value && !std::is_same<std::decay_t<_F>, std::nullptr_t>::value>>
+	static_function& operator=(_F&& f)
+	{
+		destroy();
+		construct(std::forward<_F>(f));
+		return *this;
+	}
+
+	// as std::function, calls the callable even if it is not const
+	_R operator()(Args... args) const
+	{
+		return __invoke(const_cast<char*>(__buff.data()), std::forward<Args>(args)...);
+	}
+
+	explicit operator bool() const { return __function != nullptr; }
+
+	const std::type_info& target_type() const
+	{
+		if (__function == nullptr)
+			return typeid(void);
+		else
+			return *__function->type;
+	}
+
+	// nullptr if the stored callable is not a _F
+	template <class _F>
+	_F* target()
+	{
+		return __function != nullptr && detail::static_any::is_function_for_type<_F>(__function) ? reinterpret_cast<_F*>(__buff.data()) : nullptr;
+	}
+
+	template <class _F>
+	const _F* target() const
+	{
+		return const_cast<static_function*>(this)->template target<_F>();
+	}
+
+private:
+	template <class _F>
+	static _R invoke(void* f, Args&&... args)
+	{
+		return detail::static_any::invoke_as<_R>(std::is_void<_R>{}, *reinterpret_cast<_F*>(f), std::forward<Args>(args)...);
+	}
+
+	[[noreturn]] static _R throw_bad_function_call(void*, Args&&...)
+	{
+		throw std::bad_function_call();
+	}
+
+	template <class _F>
+	void construct(_F&& f)
+	{
+		using NonConstF = std::remove_cv_t<std::remove_reference_t<_F>>;
+
+		static_assert(capacity() >= sizeof(NonConstF), "_F is too big to be stored in static_function");
+		static_assert(alignment() >= alignof(NonConstF), "_F is too aligned to be stored in static_function");
+		static_assert(std::is_constructible<NonConstF, _F&&>::value, "_F is not copy constructible, move only callables have to be moved to static_function");
+		assert(__function == nullptr);
+
+		new(__buff.data()) NonConstF(std::forward<_F>(f));
+		__function = detail::static_any::get_function_for_type<NonConstF>();
+		__invoke = &invoke<NonConstF>;
+	}
+
+	template <std::size_t _M, std::size_t _MAlign, class CopyOrMoveTag>
+	void construct_from(const static_function<_R(Args...), _M, _MAlign>& other, CopyOrMoveTag)
+	{
+		assert(__function == nullptr);
+
+		function_table_ptr_t function = other.__function;
+		if (function == nullptr)
+			return;
+
+		void* other_data = const_cast<char*>(other.__buff.data());
+		detail::static_any::count(function, CopyOrMoveTag{});
+
+		if (function->trivial)
+			detail::static_any::trivial_copy<_M>(__buff.data(), other_data, function->size);
+		else
+			call_function(function, __buff.data(), other_data, CopyOrMoveTag{});
+
+		__function = function;
+		__invoke = other.__invoke;
+	}
+
+	template <std::size_t _M, std::size_t _MAlign, class CopyOrMoveTag>
+	void assign_from(const static_function<_R(Args...), _M, _MAlign>& other, CopyOrMoveTag)
+	{
+		if (static_cast<const void*>(&other) == static_cast<const void*>(this))
+			return;
+
+		destroy();
+		construct_from(other, CopyOrMoveTag{});
+	}
+
+	void destroy()
+	{
+		if (__function != nullptr)
+		{
+			if (!__function->trivial)
+				__function->destroy(__buff.data());
+			__function = nullptr;
+			__invoke = &throw_bad_function_call;
+		}
+	}
+
+	static void call_function(function_table_ptr_t function, void* this_void_ptr, void* other_void_ptr, detail::static_any::move_tag)
+	{
+		function->move(this_void_ptr, other_void_ptr);
+	}
+
+	static void call_function(function_table_ptr_t function, void* this_void_ptr, void* other_void_ptr, detail::static_any::copy_tag)
+	{
+		function->copy(this_void_ptr, other_void_ptr);
+	}
+
+	alignas(_Align) std::array<char, _N> __buff;
+	invoker_t __invoke = &throw_bad_function_call;
+	function_table_ptr_t __function{};
+
+	template <class _S, std::size_t _M, std::size_t _MAlign>
+	friend class static_function;
+};
+
+template <class _R, class... Args, std::size_t _N, std::size_t _Align>
+bool operator==(const static_function<_R(Args...), _N, _Align>& f, std::nullptr_t) { return !f; }
+
+template <class _R, class... Args, std::size_t _N, std::size_t _Align>
+bool operator==(std::nullptr_t, const static_function<_R(Args...), _N, _Align>& f) { return !f; }
+
+template <class _R, class... Args, std::size_t _N, std::size_t _Align>
+bool operator!=(const static_function<_R(Args...), _N, _Align>& f, std::nullptr_t) { return static_cast<bool>(f); }
+
+template <class _R, class... Args, std::size_t _N, std::size_t _Align>
+bool operator!=(std::nullptr_t, const static_function<_R(Args...), _N, _Align>& f) { return static_cast<bool>(f); }
@@ -0,0 +1,49 @@
+#include "../any.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#if STATIC_ANY_CONSTEXPR_ANY_T
+
+namespace
+{
+
+struct Field
+{
+	std::int32_t id;
+	std::int32_t size;
+};
+
+constexpr static_any_t<16> defaults[] = {
+	42,
+	3.5,
+	Field{7, 16},
+	std::uint64_t(1) << 40
+};
+
+}
+
+TEST(any_t_constexpr, table)
+{
+	static_assert(defaults[0].value<std::int32_t>() == 42, "constant initialized");
+	static_assert(defaults[1].value<double>() == 3.5, "constant initialized");
+	static_assert(defaults[2].value<Field>().size == 16, "constant initialized");
+	static_assert(defaults[3].value<std::uint64_t>() == std::uint64_t(1) << 40, "constant initialized");
+
+	ASSERT_EQ(42, defaults[0].get<std::int32_t>());
+	ASSERT_EQ(3.5, defaults[1].get<double>());
+	ASSERT_EQ(7, defaults[2].get<Field>().id);
+	ASSERT_EQ(std::uint64_t(1) << 40, defaults[3].value<std::uint64_t>());
+}
+
+TEST(any_t_constexpr, runtime)
+{
+	static_any_t<16> a(Field{1, 2});
+	ASSERT_EQ(2, a.value<Field>().size);
+
+	a = 2.5;
+	ASSERT_EQ(2.5, a.value<double>());
+}
+
+#endif
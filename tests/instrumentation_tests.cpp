@@ -0,0 +1,124 @@
+#define STATIC_ANY_INSTRUMENTATION
+
+#include "../any.hpp"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+
+struct ThrowingCopy
+{
+	ThrowingCopy() = default;
+	ThrowingCopy(const ThrowingCopy&) { throw std::runtime_error("copy failed"); }
+	ThrowingCopy& operator=(const ThrowingCopy&) = default;
+};
+
+void reset_all()
+{
+	reset_static_any_counters();
+	reset_static_any_counters<int>();
+	reset_static_any_counters<std::string>();
+	reset_static_any_counters<ThrowingCopy>();
+}
+
+}
+
+TEST(any_instrumentation, copies_and_moves)
+{
+	reset_all();
+
+	static_any<32> a(std::string("foo"));
+	static_any<32> b = a;
+	static_any<32> c = std::move(b);
+
+	static_any_counters s = snapshot_static_any_counters<std::string>();
+	EXPECT_EQ(1u, s.copies);
+	EXPECT_EQ(1u, s.moves);
+
+	// the copy of a std::string can throw: the previous value is moved to a backup first
+	c = a;
+	s = snapshot_static_any_counters<std::string>();
+	EXPECT_EQ(2u, s.copies);
+	EXPECT_EQ(2u, s.moves);
+	EXPECT_EQ(1u, s.backups);
+
+	static_any<8> i(1);
+	static_any<8> j = i;
+	(void)j;
+
+	EXPECT_EQ(1u, snapshot_static_any_counters<int>().copies);
+	EXPECT_EQ(3u, snapshot_static_any_counters().copies);
+	EXPECT_EQ(2u, snapshot_static_any_counters().moves);
+}
+
+TEST(any_instrumentation, bad_casts)
+{
+	reset_all();
+
+	static_any<8> a = 1;
+	EXPECT_THROW(a.get<double>(), bad_any_cast);
+
+	compact_static_any<8> b = 1;
+	EXPECT_THROW(b.get<double>(), bad_any_cast);
+
+	static_any<8> empty;
+	EXPECT_THROW(empty.get<int>(), bad_any_cast);
+
+	EXPECT_EQ(2u, snapshot_static_any_counters<int>().bad_casts);
+	EXPECT_EQ(3u, snapshot_static_any_counters().bad_casts);
+}
+
+TEST(any_instrumentation, backups)
+{
+	reset_all();
+
+	static_any<32> a(std::string("foo"));
+	static_any<32> b;
+	b.emplace<ThrowingCopy>();
+	EXPECT_THROW(a = b, std::runtime_error);
+	EXPECT_EQ("foo", a.get<std::string>());
+
+	EXPECT_EQ(1u, snapshot_static_any_counters<std::string>().backups);
+	EXPECT_EQ(1u, snapshot_static_any_counters().backups);
+
+	hybrid_static_any<16> h(std::string("bar"));
+	const ThrowingCopy t;
+	EXPECT_THROW(h = t, std::runtime_error);
+	EXPECT_EQ(2u, snapshot_static_any_counters<std::string>().backups);
+}
+
+TEST(any_instrumentation, slow_type_check)
+{
+	reset_all();
+
+	// a function table from another module: same type hash, different address
+	using namespace detail::static_any;
+	const function_table_t other_module = *get_function_for_type<int>();
+
+	EXPECT_TRUE(is_function_for_type<int>(get_function_for_type<int>()));
+	EXPECT_EQ(0u, snapshot_static_any_counters().slow_type_checks);
+
+	EXPECT_TRUE(is_function_for_type<int>(&other_module));
+	EXPECT_FALSE(is_function_for_type<double>(&other_module));
+	EXPECT_EQ(1u, snapshot_static_any_counters<int>().slow_type_checks);
+	EXPECT_EQ(1u, snapshot_static_any_counters().slow_type_checks);
+}
+
+TEST(any_instrumentation, reset)
+{
+	static_any<8> a = 1;
+	static_any<8> b = a;
+	(void)b;
+	ASSERT_NE(0u, snapshot_static_any_counters().copies);
+
+	reset_static_any_counters();
+	EXPECT_EQ(0u, snapshot_static_any_counters().copies);
+	EXPECT_NE(0u, snapshot_static_any_counters<int>().copies);
+
+	reset_static_any_counters<int>();
+	EXPECT_EQ(0u, snapshot_static_any_counters<int>().copies);
+}
@@ -0,0 +1,125 @@
+#include "../static_any_interface.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+struct Strategy
+{
+	double (*apply)(void* self, double x);
+	std::string (*name)(const void* self);
+
+	template <class _T>
+	static constexpr Strategy make() { return { &apply_of<_T>, &name_of<_T> }; }
+
+	template <class _T>
+	static double apply_of(void* self, double x) { return static_cast<_T*>(self)->apply(x); }
+
+	template <class _T>
+	static std::string name_of(const void* self) { return static_cast<const _T*>(self)->name(); }
+};
+
+struct Scale
+{
+	double apply(double x) { ++calls; return x * factor; }
+	std::string name() const { return "scale"; }
+
+	double factor;
+	int calls;
+};
+
+struct Offset
+{
+	double apply(double x) const { return x + *offset; }
+	std::string name() const { return "offset"; }
+
+	std::shared_ptr<double> offset;
+};
+
+// a std::shared_ptr does not point into itself
+template <>
+struct static_any_trivially_relocatable<Offset> : std::true_type {};
+
+TEST(interface_any, call)
+{
+	interface_static_any<Strategy, 32> s = Scale{2., 0};
+	ASSERT_EQ(3., s.call(&Strategy::apply, 1.5));
+	ASSERT_EQ("scale", s.call(&Strategy::name));
+	ASSERT_EQ(1, s.get<Scale>().calls);
+
+	s = Offset{std::make_shared<double>(10.)};
+	ASSERT_EQ(11.5, s.call(&Strategy::apply, 1.5));
+	ASSERT_TRUE(s.has<Offset>());
+
+	const auto& cs = s;
+	ASSERT_EQ("offset", cs.call(&Strategy::name));
+}
+
+TEST(interface_any, empty)
+{
+	interface_static_any<Strategy, 32> s;
+	ASSERT_TRUE(s.empty());
+	ASSERT_EQ(nullptr, s.operations());
+	EXPECT_THROW(s.call(&Strategy::name), bad_any_cast);
+
+	s.emplace<Scale>(Scale{3., 0});
+	ASSERT_EQ(3., s.call(&Strategy::apply, 1.));
+
+	s.reset();
+	EXPECT_THROW(s.call(&Strategy::apply, 1.), bad_any_cast);
+}
+
+TEST(interface_any, copy_and_move)
+{
+	interface_static_any<Strategy, 16> a = Offset{std::make_shared<double>(1.)};
+	interface_static_any<Strategy, 32> b(a);
+	ASSERT_EQ(2., b.call(&Strategy::apply, 1.));
+
+	interface_static_any<Strategy, 32> c = std::move(b);
+	ASSERT_EQ("offset", c.call(&Strategy::name));
+
+	c = Scale{2., 0};
+	c = a;
+	ASSERT_EQ("offset", c.call(&Strategy::name));
+	ASSERT_EQ(a.operations(), c.operations());
+}
+
+TEST(interface_any, heterogeneous_array)
+{
+	interface_static_any<Strategy, 32> strategies[] = { Scale{2., 0}, Offset{std::make_shared<double>(1.)}, Scale{.5, 0} };
+
+	double x = 4.;
+	for (auto& s : strategies)
+		x = s.call(&Strategy::apply, x);
+	ASSERT_EQ(4.5, x);
+}
+
+TEST(interface_any, moved_from)
+{
+	// Offset is relocated: the moved-from objects are empty, and have no operations anymore
+	interface_static_any<Strategy, 32> a = Offset{std::make_shared<double>(1.)};
+	interface_static_any<Strategy, 32> b(std::move(a));
+	ASSERT_TRUE(a.empty());
+	ASSERT_EQ(nullptr, a.operations());
+	EXPECT_THROW(a.call(&Strategy::apply, 1.), bad_any_cast);
+
+	interface_static_any<Strategy, 64> c(std::move(b));
+	ASSERT_EQ(nullptr, b.operations());
+
+	interface_static_any<Strategy, 64> d;
+	d = std::move(c);
+	ASSERT_EQ(nullptr, c.operations());
+	ASSERT_EQ(2., d.call(&Strategy::apply, 1.));
+
+	interface_static_any<Strategy, 16> f = Offset{std::make_shared<double>(2.)};
+	d = std::move(f);
+	ASSERT_EQ(nullptr, f.operations());
+	ASSERT_EQ(3., d.call(&Strategy::apply, 1.));
+
+	// Scale is not relocatable, it is moved and the moved-from objects keep their value
+	interface_static_any<Strategy, 32> g = Scale{2., 0};
+	interface_static_any<Strategy, 32> h(std::move(g));
+	ASSERT_EQ(4., g.call(&Strategy::apply, 2.));
+}
@@ -0,0 +1,124 @@
+#include "../static_any_journal.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace
+{
+
+struct Trade
+{
+	int id;
+	double price;
+};
+
+std::string journal_path(const char* name)
+{
+	const std::string path = ::testing::TempDir() + "static_any_journal_" + name;
+	std::remove(path.c_str());
+	return path;
+}
+
+}
+
+TEST(any_journal, append_and_read)
+{
+	const std::string path = journal_path("append_and_read");
+	{
+		journal_writer<16> writer(path, 4);
+		ASSERT_EQ(4u, writer.capacity());
+		ASSERT_TRUE(writer.append(7));
+		ASSERT_TRUE(writer.append(Trade{1, 99.5}));
+		ASSERT_TRUE(writer.append(2.5));
+		ASSERT_EQ(3u, writer.size());
+	}
+
+	journal_reader<16> reader(path);
+	ASSERT_EQ(3u, reader.size());
+
+	ASSERT_TRUE(reader[0].has<int>());
+	ASSERT_EQ(7, reader[0].get<int>());
+	ASSERT_TRUE(reader[1].has<Trade>());
+	ASSERT_EQ(99.5, reader[1].get<Trade>().price);
+	ASSERT_FALSE(reader[2].has<int>());
+	ASSERT_EQ(2.5, reader[2].get<double>());
+
+	std::vector<std::uint64_t> tags;
+	for (const auto& record : reader)
+		tags.push_back(record.tag);
+	ASSERT_EQ((std::vector<std::uint64_t>{journal_record<16>::tag_of<int>(), journal_record<16>::tag_of<Trade>(), journal_record<16>::tag_of<double>()}), tags);
+
+	std::remove(path.c_str());
+}
+
+TEST(any_journal, full)
+{
+	const std::string path = journal_path("full");
+	journal_writer<8> writer(path, 2, 1);
+	ASSERT_TRUE(writer.append(1));
+	ASSERT_TRUE(writer.append(2));
+	ASSERT_FALSE(writer.append(3));
+	ASSERT_EQ(2u, writer.size());
+
+	std::remove(path.c_str());
+}
+
+TEST(any_journal, reopen)
+{
+	const std::string path = journal_path("reopen");
+	{
+		journal_writer<8> writer(path, 8);
+		writer.append(1);
+	}
+	{
+		journal_writer<8> writer(path, 8);
+		ASSERT_EQ(1u, writer.size());
+		writer.append(2);
+		writer.sync();
+	}
+
+	journal_reader<8> reader(path);
+	ASSERT_EQ(2u, reader.size());
+	ASSERT_EQ(1, reader[0].get<int>());
+	ASSERT_EQ(2, reader[1].get<int>());
+
+	// records of another size
+	EXPECT_THROW(journal_reader<16>{path}, std::runtime_error);
+	EXPECT_THROW(journal_writer<32>(path, 8), std::runtime_error);
+
+	std::remove(path.c_str());
+	EXPECT_THROW(journal_reader<8>{path}, std::system_error);
+}
+
+TEST(any_journal, truncated_header)
+{
+	const std::string path = journal_path("truncated_header");
+	std::FILE* file = std::fopen(path.c_str(), "wb");
+	ASSERT_NE(nullptr, file);
+	std::fputc('S', file);
+	std::fclose(file);
+
+	EXPECT_THROW(journal_writer<8>(path, 8), std::runtime_error);
+	EXPECT_THROW(journal_reader<8>{path}, std::runtime_error);
+
+	std::remove(path.c_str());
+}
+
+TEST(any_journal, read_while_writing)
+{
+	const std::string path = journal_path("read_while_writing");
+	journal_writer<8> writer(path, 16);
+	journal_reader<8> reader(path);
+	ASSERT_TRUE(reader.empty());
+
+	writer.append(1);
+	writer.append(2.);
+	ASSERT_EQ(2u, reader.size());
+	ASSERT_EQ(2., reader[1].get<double>());
+
+	std::remove(path.c_str());
+}
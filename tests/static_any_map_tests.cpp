@@ -0,0 +1,204 @@
+#include "../static_any_map.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+TEST(any_map, empty)
+{
+	static_any_map<32, int> m;
+	ASSERT_TRUE(m.empty());
+	ASSERT_EQ(0, m.size());
+	ASSERT_EQ(nullptr, m.find(1));
+	ASSERT_FALSE(m.erase(1));
+}
+
+TEST(any_map, heterogeneous_keys)
+{
+	static_any_map<32, int> m;
+	ASSERT_TRUE(m.try_emplace(1, 10).second);
+	ASSERT_TRUE(m.try_emplace(1L, 20).second);
+	ASSERT_TRUE(m.try_emplace(std::string("1"), 30).second);
+	ASSERT_FALSE(m.try_emplace(1, 40).second);
+
+	ASSERT_EQ(3, m.size());
+	ASSERT_EQ(10, *m.find(1));
+	ASSERT_EQ(20, *m.find(1L));
+	ASSERT_EQ(30, *m.find(std::string("1")));
+	ASSERT_EQ(nullptr, m.find(1.));
+
+	// looked up as a static_any
+	ASSERT_EQ(10, *m.find(static_any<16>(1)));
+	ASSERT_EQ(30, *m.find(static_any<32>(std::string("1"))));
+
+	m[2.5] = 50;
+	ASSERT_EQ(50, m[2.5]);
+	ASSERT_EQ(4, m.size());
+}
+
+TEST(any_map, grow_and_erase)
+{
+	static_any_map<32, std::string> m;
+	for (int i = 0; i < 1000; ++i)
+	{
+		m.try_emplace(i, std::to_string(i));
+		m.try_emplace(std::to_string(i), std::to_string(-i));
+	}
+
+	ASSERT_EQ(2000, m.size());
+	for (int i = 0; i < 1000; i += 2)
+	{
+		ASSERT_TRUE(m.erase(i));
+		ASSERT_TRUE(m.erase(std::to_string(i + 1)));
+	}
+
+	ASSERT_EQ(1000, m.size());
+	for (int i = 0; i < 1000; ++i)
+	{
+		if (i % 2 == 0)
+		{
+			ASSERT_EQ(nullptr, m.find(i));
+			ASSERT_EQ(std::to_string(-i), *m.find(std::to_string(i)));
+		}
+		else
+		{
+			ASSERT_EQ(std::to_string(i), *m.find(i));
+			ASSERT_EQ(nullptr, m.find(std::to_string(i)));
+		}
+	}
+
+	int count = 0;
+	m.for_each([&count](const static_any<32>&, std::string&) { ++count; });
+	ASSERT_EQ(1000, count);
+}
+
+TEST(any_map, copy_and_move)
+{
+	static_any_map<32, std::unique_ptr<int>> m;
+	m.try_emplace(std::string("foo"), std::make_unique<int>(1));
+	m.try_emplace(2, std::make_unique<int>(2));
+
+	auto n = std::move(m);
+	ASSERT_TRUE(m.empty());
+	ASSERT_EQ(1, **n.find(std::string("foo")));
+
+	static_any_map<32, std::string> s(100);
+	const std::size_t buckets = s.bucket_count();
+	for (int i = 0; i < 100; ++i)
+		s[i] = std::to_string(i);
+	ASSERT_EQ(buckets, s.bucket_count());
+
+	static_any_map<32, std::string> t;
+	t = s;
+	s.clear();
+	ASSERT_TRUE(s.empty());
+	ASSERT_EQ(100, t.size());
+	ASSERT_EQ("42", *t.find(42));
+}
+
+TEST(any_map, bad_key)
+{
+	struct NotHashable { int i; };
+
+	static_any_map<32, int> m;
+	EXPECT_THROW(m.try_emplace(static_any<32>(NotHashable{1}), 1), bad_any_hash);
+	ASSERT_TRUE(m.empty());
+}
+
+// a key whose move constructor may throw, but does not: the map relocates it when growing
+struct MayThrowKey
+{
+	explicit MayThrowKey(int value) : i(value) {}
+	MayThrowKey(const MayThrowKey&) = default;
+	MayThrowKey(MayThrowKey&& other) noexcept(false) : i(other.i) {}
+
+	bool operator==(const MayThrowKey& other) const { return i == other.i; }
+
+	int i;
+};
+
+namespace std
+{
+template <>
+struct hash<MayThrowKey>
+{
+	std::size_t operator()(const MayThrowKey& key) const { return std::hash<int>()(key.i); }
+};
+}
+
+struct ThrowingValue
+{
+	explicit ThrowingValue(int value) : i(value)
+	{
+		if (value < 0)
+			throw std::invalid_argument("negative");
+	}
+
+	int i;
+};
+
+TEST(any_map, grow_with_may_throw_keys)
+{
+	static_any_map<16, int> m;
+	for (int i = 0; i < 100; ++i)
+		m.try_emplace(MayThrowKey(i), i);
+
+	ASSERT_EQ(100, m.size());
+	for (int i = 0; i < 100; ++i)
+		ASSERT_EQ(i, *m.find(MayThrowKey(i)));
+
+	for (int i = 0; i < 100; i += 2)
+		ASSERT_TRUE(m.erase(MayThrowKey(i)));
+	for (int i = 1; i < 100; i += 2)
+		ASSERT_EQ(i, *m.find(MayThrowKey(i)));
+}
+
+TEST(any_map, insertion_strong_guarantee)
+{
+	static_any_map<16, ThrowingValue> m;
+	for (int i = 0; i < 12; ++i)
+		m.try_emplace(i, i);
+	const std::size_t buckets = m.bucket_count();
+
+	// the table grows before the value is constructed
+	EXPECT_THROW(m.try_emplace(12, -1), std::invalid_argument);
+	ASSERT_LT(buckets, m.bucket_count());
+	ASSERT_EQ(12, m.size());
+	ASSERT_EQ(nullptr, m.find(12));
+	for (int i = 0; i < 12; ++i)
+		ASSERT_EQ(i, m.find(i)->i);
+}
+
+template <std::size_t Index>
+struct Counted
+{
+	Counted() { ++alive; }
+	Counted(const Counted&) { ++alive; }
+	Counted(Counted&&) noexcept { ++alive; }
+	~Counted() { --alive; }
+
+	static int alive;
+};
+
+template <std::size_t Index> int Counted<Index>::alive = 0;
+
+TEST(any_map, destruction)
+{
+	{
+		static_any_map<16, Counted<1>> m;
+		for (int i = 0; i < 100; ++i)
+			m[i];
+
+		ASSERT_EQ(100, Counted<1>::alive);
+		for (int i = 0; i < 50; ++i)
+			m.erase(i);
+		ASSERT_EQ(50, Counted<1>::alive);
+
+		auto n = m;
+		ASSERT_EQ(100, Counted<1>::alive);
+	}
+
+	ASSERT_EQ(0, Counted<1>::alive);
+}
@@ -0,0 +1,282 @@
+#include "../static_any_queue.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct Counted
+{
+	Counted() { ++alive; }
+	Counted(const Counted&) { ++alive; }
+	Counted(Counted&&) noexcept { ++alive; }
+	~Counted() { --alive; }
+
+	static int alive;
+};
+
+int Counted::alive = 0;
+
+}
+
+TEST(any_spsc_queue, fifo)
+{
+	spsc_queue<static_any<32>, 4> q;
+	ASSERT_TRUE(q.empty());
+
+	ASSERT_TRUE(q.try_emplace<int>(1));
+	ASSERT_TRUE(q.try_emplace<std::string>("foo"));
+	ASSERT_TRUE(q.try_push(2.5));
+	ASSERT_TRUE(q.try_push(static_any<16>(3)));
+	ASSERT_FALSE(q.try_push(4));
+	ASSERT_FALSE(q.empty());
+
+	static_any<32> a;
+	ASSERT_TRUE(q.try_pop(a));
+	ASSERT_EQ(1, a.get<int>());
+
+	ASSERT_TRUE(q.try_consume([](static_any<32>& any) { ASSERT_EQ("foo", any.get<std::string>()); }));
+	ASSERT_TRUE(q.try_push(4));
+
+	ASSERT_TRUE(q.try_pop(a));
+	ASSERT_EQ(2.5, a.get<double>());
+	ASSERT_TRUE(q.try_pop(a));
+	ASSERT_EQ(3, a.get<int>());
+	ASSERT_TRUE(q.try_pop(a));
+	ASSERT_EQ(4, a.get<int>());
+
+	ASSERT_FALSE(q.try_pop(a));
+	ASSERT_TRUE(q.empty());
+}
+
+TEST(any_spsc_queue, destroyed_once)
+{
+	{
+		spsc_queue<static_any<8>, 8> q;
+		for (int i = 0; i < 5; ++i)
+			ASSERT_TRUE(q.try_emplace<Counted>());
+		ASSERT_EQ(5, Counted::alive);
+
+		ASSERT_TRUE(q.try_consume([](static_any<8>&) { ASSERT_EQ(5, Counted::alive); }));
+		ASSERT_EQ(4, Counted::alive);
+	}
+	ASSERT_EQ(0, Counted::alive);
+}
+
+TEST(any_spsc_queue, trivial_slots)
+{
+	spsc_queue<static_any_t<8>, 2> q;
+	ASSERT_TRUE(q.try_emplace<int>(7));
+	ASSERT_TRUE(q.try_push(.5));
+
+	static_any_t<8> a;
+	ASSERT_TRUE(q.try_pop(a));
+	ASSERT_EQ(7, a.get<int>());
+	ASSERT_TRUE(q.try_pop(a));
+	ASSERT_EQ(.5, a.get<double>());
+}
+
+TEST(any_spsc_queue, batch)
+{
+	spsc_queue<static_any<8>, 8, 4> q;
+	for (int i = 0; i < 3; ++i)
+		ASSERT_TRUE(q.try_push(i));
+	ASSERT_TRUE(q.empty());
+
+	ASSERT_TRUE(q.try_push(3));
+	ASSERT_FALSE(q.empty());
+
+	ASSERT_TRUE(q.try_push(4));
+	static_any<8> a;
+	for (int i = 0; i < 4; ++i)
+	{
+		ASSERT_TRUE(q.try_pop(a));
+		ASSERT_EQ(i, a.get<int>());
+	}
+	ASSERT_FALSE(q.try_pop(a));
+
+	q.flush();
+	ASSERT_TRUE(q.try_pop(a));
+	ASSERT_EQ(4, a.get<int>());
+
+	// the last pop is not published yet: the producer sees one slot less
+	for (int i = 0; i < 7; ++i)
+		ASSERT_TRUE(q.try_push(i));
+	ASSERT_FALSE(q.try_push(7));
+
+	ASSERT_TRUE(q.try_pop(a));
+	ASSERT_EQ(0, a.get<int>());
+	ASSERT_TRUE(q.try_push(7));
+	ASSERT_FALSE(q.try_push(8));
+}
+
+TEST(any_spsc_queue, threads)
+{
+	static const int count = 100000;
+	spsc_queue<static_any<32>, 64, 8> q;
+
+	std::thread producer([&q]()
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			if (i % 3 == 0)
+				while (!q.try_emplace<std::string>(std::to_string(i)));
+			else
+				while (!q.try_emplace<int>(i));
+		}
+		q.flush();
+	});
+
+	int expected = 0;
+	while (expected < count)
+	{
+		q.try_consume([&expected](static_any<32>& any)
+		{
+			if (expected % 3 == 0)
+				ASSERT_EQ(std::to_string(expected), any.get<std::string>());
+			else
+				ASSERT_EQ(expected, any.get<int>());
+			++expected;
+		});
+	}
+
+	producer.join();
+	ASSERT_TRUE(q.empty());
+}
+
+namespace
+{
+
+struct ThrowingCtor
+{
+	explicit ThrowingCtor(bool fail)
+	{
+		if (fail)
+			throw std::runtime_error("construction failed");
+	}
+};
+
+}
+
+TEST(any_mpmc_queue, fifo)
+{
+	mpmc_queue<static_any<32>, 4> q;
+
+	ASSERT_TRUE(q.try_emplace<int>(1));
+	ASSERT_TRUE(q.try_emplace<std::string>("foo"));
+	ASSERT_TRUE(q.try_push(2.5));
+	ASSERT_TRUE(q.try_push(static_any<16>(3)));
+	ASSERT_FALSE(q.try_push(4));
+
+	static_any<32> a;
+	ASSERT_TRUE(q.try_pop(a));
+	ASSERT_EQ(1, a.get<int>());
+	ASSERT_TRUE(q.try_consume([](static_any<32>& any) { ASSERT_EQ("foo", any.get<std::string>()); }));
+	ASSERT_TRUE(q.try_push(4));
+
+	ASSERT_TRUE(q.try_pop(a));
+	ASSERT_EQ(2.5, a.get<double>());
+	ASSERT_TRUE(q.try_pop(a));
+	ASSERT_EQ(3, a.get<int>());
+	ASSERT_TRUE(q.try_pop(a));
+	ASSERT_EQ(4, a.get<int>());
+	ASSERT_FALSE(q.try_pop(a));
+}
+
+TEST(any_mpmc_queue, destroyed_once)
+{
+	{
+		mpmc_queue<static_any<8>, 8> q;
+		for (int i = 0; i < 5; ++i)
+			ASSERT_TRUE(q.try_emplace<Counted>());
+		ASSERT_EQ(5, Counted::alive);
+
+		ASSERT_TRUE(q.try_consume([](static_any<8>&) { ASSERT_EQ(5, Counted::alive); }));
+		ASSERT_EQ(4, Counted::alive);
+	}
+	ASSERT_EQ(0, Counted::alive);
+}
+
+TEST(any_mpmc_queue, throwing_construction)
+{
+	mpmc_queue<static_any<8>, 4> q;
+	ASSERT_TRUE(q.try_push(1));
+	EXPECT_THROW(q.try_emplace<ThrowingCtor>(true), std::runtime_error);
+	ASSERT_TRUE(q.try_push(2));
+
+	static_any<8> a;
+	ASSERT_TRUE(q.try_pop(a));
+	ASSERT_EQ(1, a.get<int>());
+	ASSERT_TRUE(q.try_pop(a));
+	ASSERT_EQ(2, a.get<int>());
+	ASSERT_FALSE(q.try_pop(a));
+}
+
+TEST(any_mpmc_queue, empty_any)
+{
+	mpmc_queue<static_any<16>, 4> q;
+	ASSERT_TRUE(q.try_push(static_any<16>()));
+	EXPECT_THROW(q.try_emplace<ThrowingCtor>(true), std::runtime_error);
+	ASSERT_TRUE(q.try_push(1));
+
+	// the empty any pushed is a message, the failed construction is not
+	static_any<16> a(2);
+	ASSERT_TRUE(q.try_pop(a));
+	ASSERT_TRUE(a.empty());
+	ASSERT_TRUE(q.try_pop(a));
+	ASSERT_EQ(1, a.get<int>());
+	ASSERT_FALSE(q.try_pop(a));
+}
+
+TEST(any_mpmc_queue, threads)
+{
+	static const int producers = 3;
+	static const int consumers = 3;
+	static const int count = 30000;
+
+	mpmc_queue<static_any<32>, 64> q;
+	std::atomic<long> sum{0};
+	std::atomic<int> consumed{0};
+
+	std::vector<std::thread> threads;
+	for (int p = 0; p < producers; ++p)
+	{
+		threads.emplace_back([&q, p]()
+		{
+			for (int i = p; i < count; i += producers)
+			{
+				if (i % 2 == 0)
+					while (!q.try_emplace<std::string>(std::to_string(i)));
+				else
+					while (!q.try_emplace<int>(i));
+			}
+		});
+	}
+
+	for (int c = 0; c < consumers; ++c)
+	{
+		threads.emplace_back([&q, &sum, &consumed]()
+		{
+			while (consumed.load() < count)
+			{
+				q.try_consume([&sum, &consumed](static_any<32>& any)
+				{
+					sum += any.has<int>() ? any.get<int>() : std::stoi(any.get<std::string>());
+					++consumed;
+				});
+			}
+		});
+	}
+
+	for (std::thread& t : threads)
+		t.join();
+
+	ASSERT_EQ(count, consumed.load());
+	ASSERT_EQ(long(count) * (count - 1) / 2, sum.load());
+}
@@ -0,0 +1,174 @@
+#include "../static_any_vector.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+TEST(any_vector, empty)
+{
+	static_any_vector<32> v;
+	ASSERT_TRUE(v.empty());
+	ASSERT_EQ(0, v.size());
+	ASSERT_EQ(0, v.count<int>());
+	ASSERT_EQ(nullptr, v.data<int>());
+}
+
+TEST(any_vector, grouped_by_type)
+{
+	static_any_vector<32> v;
+	for (int i = 0; i < 10; ++i)
+	{
+		v.push_back(i);
+		v.push_back(std::to_string(i));
+		v.push_back(i * .5);
+	}
+
+	ASSERT_EQ(30, v.size());
+	ASSERT_EQ(10, v.count<int>());
+	ASSERT_EQ(10, v.count<std::string>());
+	ASSERT_EQ(10, v.count<double>());
+	ASSERT_EQ(0, v.count<float>());
+
+	const int* ints = v.data<int>();
+	for (int i = 0; i < 10; ++i)
+		ASSERT_EQ(i, ints[i]);
+
+	std::string all;
+	v.for_each<std::string>([&all](const std::string& s) { all += s; });
+	ASSERT_EQ("0123456789", all);
+}
+
+TEST(any_vector, visit)
+{
+	static_any_vector<32> v;
+	v.push_back(1);
+	v.push_back(2.5);
+	v.push_back(std::string("foo"));
+	v.push_back(3);
+
+	struct visitor
+	{
+		void operator()(int i) { sum += i; }
+		void operator()(double d) { sum += d; }
+		double sum;
+	};
+
+	visitor vis{.0};
+	v.visit<int, double, float>(vis);
+	ASSERT_EQ(6.5, vis.sum);
+
+	const auto& cv = v;
+	int calls = 0;
+	cv.visit<std::string>([&calls](const std::string& s) { ASSERT_EQ("foo", s); ++calls; });
+	ASSERT_EQ(1, calls);
+}
+
+TEST(any_vector, mutate)
+{
+	static_any_vector<32> v;
+	v.push_back(1);
+	v.push_back(2);
+	v.for_each<int>([](int& i) { i *= 10; });
+
+	ASSERT_EQ(10, v.data<int>()[0]);
+	ASSERT_EQ(20, v.data<int>()[1]);
+}
+
+TEST(any_vector, keep_order)
+{
+	static_any_vector<32, true> v;
+	v.push_back(1);
+	v.push_back(std::string("foo"));
+	v.push_back(2);
+
+	ASSERT_EQ(typeid(int), v.type(0));
+	ASSERT_EQ(typeid(std::string), v.type(1));
+	ASSERT_TRUE(v.has<int>(2));
+	ASSERT_FALSE(v.has<int>(1));
+
+	ASSERT_EQ(1, v.get<int>(0));
+	ASSERT_EQ("foo", v.get<std::string>(1));
+	ASSERT_EQ(2, v.get<int>(2));
+	EXPECT_THROW(v.get<double>(0), bad_any_cast);
+}
+
+TEST(any_vector, copy)
+{
+	static_any_vector<32, true> v;
+	for (int i = 0; i < 100; ++i)
+	{
+		v.push_back(i);
+		v.push_back(std::to_string(i));
+	}
+
+	auto w = v;
+	v.clear();
+	ASSERT_TRUE(v.empty());
+
+	ASSERT_EQ(200, w.size());
+	ASSERT_EQ(99, w.get<int>(198));
+	ASSERT_EQ("99", w.get<std::string>(199));
+
+	v = w;
+	ASSERT_EQ("42", v.get<std::string>(85));
+}
+
+TEST(any_vector, moved_from)
+{
+	static_any_vector<32> v;
+	v.push_back(1);
+	v.push_back(std::string("foo"));
+
+	auto w = std::move(v);
+	ASSERT_EQ(2, w.size());
+	ASSERT_EQ(0, v.size());
+	ASSERT_TRUE(v.empty());
+	ASSERT_EQ(0, v.count<int>());
+
+	v.push_back(2);
+	ASSERT_EQ(1, v.size());
+
+	w = std::move(v);
+	ASSERT_EQ(1, w.size());
+	ASSERT_EQ(2, w.data<int>()[0]);
+	ASSERT_TRUE(v.empty());
+}
+
+TEST(any_vector, move_only)
+{
+	static_any_vector<16> v;
+	for (int i = 0; i < 100; ++i)
+		v.push_back(std::make_unique<int>(i));
+
+	ASSERT_EQ(42, *v.data<std::unique_ptr<int>>()[42]);
+	EXPECT_THROW(auto w = v, bad_any_copy);
+}
+
+template <std::size_t Index>
+struct Counted
+{
+	Counted() { ++alive; }
+	Counted(const Counted&) { ++alive; }
+	Counted(Counted&&) noexcept { ++alive; }
+	~Counted() { --alive; }
+
+	static int alive;
+};
+
+template <std::size_t Index> int Counted<Index>::alive = 0;
+
+TEST(any_vector, destruction)
+{
+	{
+		static_any_vector<16> v;
+		for (int i = 0; i < 100; ++i)
+			v.emplace_back<Counted<0>>();
+
+		ASSERT_EQ(100, Counted<0>::alive);
+
+		auto w = v;
+		ASSERT_EQ(200, Counted<0>::alive);
+	}
+
+	ASSERT_EQ(0, Counted<0>::alive);
+}
@@ -0,0 +1,136 @@
+#include "../static_function.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+TEST(static_function, call)
+{
+	int base = 10;
+	static_function<int(int)> f = [base](int i) { return base + i; };
+
+	ASSERT_TRUE(static_cast<bool>(f));
+	ASSERT_EQ(15, f(5));
+
+	f = [](int i) { return i * 2; };
+	ASSERT_EQ(10, f(5));
+
+	static_function<std::string(const std::string&, std::string&&)> concat = [](const std::string& a, std::string&& b) { return a + b; };
+	ASSERT_EQ("foobar", concat("foo", std::string("bar")));
+}
+
+int add_one(int i) { return i + 1; }
+
+TEST(static_function, function_pointer_and_void_result)
+{
+	static_function<int(int)> f = &add_one;
+	ASSERT_EQ(2, f(1));
+
+	// the result is discarded
+	static_function<void(int)> g = &add_one;
+	g(1);
+}
+
+TEST(static_function, empty)
+{
+	static_function<void()> f;
+	ASSERT_FALSE(static_cast<bool>(f));
+	ASSERT_TRUE(f == nullptr);
+	ASSERT_EQ(typeid(void), f.target_type());
+	EXPECT_THROW(f(), std::bad_function_call);
+
+	f = [] {};
+	ASSERT_TRUE(f != nullptr);
+	f = nullptr;
+	EXPECT_THROW(f(), std::bad_function_call);
+}
+
+TEST(static_function, big_capture)
+{
+	std::array<char, 48> data{};
+	data[47] = 'x';
+
+	static_function<char(), 64> f = [data] { return data[47]; };
+	static_function<char(), 64> g(f);
+	ASSERT_EQ('x', g());
+
+	static_assert(!std::is_constructible<static_function<char(), 32>, static_function<char(), 64>>::value, "too small");
+	static_function<char(), 128> h(std::move(f));
+	ASSERT_EQ('x', h());
+}
+
+TEST(static_function, mutable_callable)
+{
+	static_function<int()> counter = [i = 0]() mutable { return ++i; };
+	ASSERT_EQ(1, counter());
+	ASSERT_EQ(2, counter());
+
+	auto copy = counter;
+	ASSERT_EQ(3, copy());
+	ASSERT_EQ(3, counter());
+}
+
+TEST(static_function, move_only)
+{
+	static_function<int()> f = [p = std::make_unique<int>(42)] { return *p; };
+	static_function<int()> g(std::move(f));
+	ASSERT_EQ(42, g());
+
+	EXPECT_THROW(static_function<int()> h(g), bad_any_copy);
+}
+
+TEST(static_function, vector_growth)
+{
+	static_assert(std::is_nothrow_move_constructible<static_function<int()>>::value, "moved by std::vector");
+
+	std::vector<static_function<int()>> functions;
+	for (int i = 0; i < 100; ++i)
+		functions.emplace_back([p = std::make_unique<int>(i)] { return *p; });
+
+	for (int i = 0; i < 100; ++i)
+		ASSERT_EQ(i, functions[static_cast<std::size_t>(i)]());
+}
+
+TEST(static_function, target)
+{
+	static_function<int(int)> f = &add_one;
+	ASSERT_EQ(typeid(int(*)(int)), f.target_type());
+	ASSERT_NE(nullptr, f.target<int(*)(int)>());
+	ASSERT_EQ(nullptr, f.target<int>());
+}
+
+struct CountedCallable
+{
+	CountedCallable() { ++alive; }
+	CountedCallable(const CountedCallable&) { ++alive; }
+	CountedCallable(CountedCallable&&) noexcept { ++alive; }
+	~CountedCallable() { --alive; }
+
+	void operator()() const {}
+
+	static int alive;
+};
+
+int CountedCallable::alive = 0;
+
+TEST(static_function, destruction)
+{
+	{
+		static_function<void()> f = CountedCallable();
+		ASSERT_EQ(1, CountedCallable::alive);
+
+		static_function<void()> g = f;
+		ASSERT_EQ(2, CountedCallable::alive);
+
+		g = [] {};
+		ASSERT_EQ(1, CountedCallable::alive);
+
+		g = std::move(f);
+		ASSERT_EQ(2, CountedCallable::alive);
+	}
+
+	ASSERT_EQ(0, CountedCallable::alive);
+}
@@ -3,6 +3,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <map>
+#include <vector>
+
 struct A
 {
 	explicit A(int i) :
@@ -13,7 +17,7 @@ struct A
 TEST(any, readme_example)
 {
 	static_any<32> a; // on g++ 5.x sizeof(std::string) is 32
-	static_assert(sizeof(a) == 32 + sizeof(std::ptrdiff_t), "impossible");
+	static_assert(sizeof(a) == 32 + std::max(sizeof(std::ptrdiff_t), alignof(std::max_align_t)), "impossible");
 
 	a = 1234;
 	ASSERT_EQ(1234, a.get<int>());
@@ -35,10 +39,37 @@ TEST(any, readme_example)
 
 TEST(any, test_sizeof)
 {
-	static_any<16> a;
+	static_any<16, alignof(std::ptrdiff_t)> a;
 	ASSERT_EQ(16 + sizeof(std::ptrdiff_t), sizeof(a));
 }
 
+TEST(any, alignment)
+{
+	static_assert(static_any<32>::alignment() == alignof(std::max_align_t), "default alignment");
+	static_assert(static_any<4>::alignment() == 4, "alignment limited by capacity");
+	static_assert(static_any_t<8>::alignment() == 8, "alignment limited by capacity");
+	static_assert(alignof(static_any_t<8>) == 8, "buffer alignment");
+
+	struct alignas(64) Aligned { double d; };
+
+	static_any<64, 64> a = Aligned{.5};
+	ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(&a.get<Aligned>()) % 64);
+	ASSERT_EQ(.5, a.get<Aligned>().d);
+
+	std::vector<static_any_t<8>> v(3, static_any_t<8>(.5));
+	for (const auto& t : v)
+		ASSERT_EQ(0, reinterpret_cast<std::uintptr_t>(&t.get<double>()) % alignof(double));
+}
+
+TEST(any, any_to_more_aligned_any)
+{
+	static_any<8> a(7);
+	static_any<16, 16> b(a);
+	ASSERT_EQ(7, b.get<int>());
+
+	static_assert(!std::is_constructible<static_any<16, 8>, static_any<16, 16>>::value, "less aligned");
+}
+
 TEST(any, capacity)
 {
 	static_any<32> a;
@@ -494,6 +525,51 @@ TEST(any, any_cast_reference_wrong_type_from_to)
 	}
 }
 
+TEST(any, bad_any_cast_what)
+{
+	const bad_any_cast ex(typeid(int), typeid(float));
+	const std::string what = ex.what();
+	ASSERT_NE(std::string::npos, what.find(typeid(int).name()));
+	ASSERT_NE(std::string::npos, what.find(typeid(float).name()));
+	ASSERT_EQ(ex.what(), ex.what());
+
+	static_assert(std::is_nothrow_copy_constructible<bad_any_cast>::value, "copied by std::exception_ptr");
+	const bad_any_cast copy(ex);
+	ASSERT_EQ(what, copy.what());
+}
+
+struct a_type_whose_name_is_longer_than_the_message_of_bad_any_cast_can_hold_so_that_it_gets_truncated_when_formatted_by_the_constructor_of_bad_any_cast_which_never_allocates_to_format_it_as_it_writes_in_a_fixed_buffer {};
+
+TEST(any, bad_any_cast_what_truncated)
+{
+	const bad_any_cast ex(typeid(a_type_whose_name_is_longer_than_the_message_of_bad_any_cast_can_hold_so_that_it_gets_truncated_when_formatted_by_the_constructor_of_bad_any_cast_which_never_allocates_to_format_it_as_it_writes_in_a_fixed_buffer), typeid(int));
+	const std::string what = ex.what();
+	ASSERT_EQ(255, what.size());
+	ASSERT_EQ(0, what.find("failed conversion using any_cast: stored type "));
+}
+
+TEST(any, try_get)
+{
+	static_any<32> a(7);
+	ASSERT_NE(nullptr, a.try_get<int>());
+	ASSERT_EQ(7, *a.try_get<int>());
+	ASSERT_EQ(nullptr, a.try_get<float>());
+
+	*a.try_get<int>() = 8;
+	const static_any<32>& c = a;
+	ASSERT_EQ(8, *c.try_get<const int>());
+	ASSERT_EQ(8, c.unchecked_get<int>());
+
+	a.unchecked_get<int>() = 9;
+	ASSERT_EQ(9, a.get<int>());
+
+	a.reset();
+	ASSERT_EQ(nullptr, a.try_get<int>());
+
+	static_assert(noexcept(a.try_get<int>()), "try_get does not throw");
+	static_assert(noexcept(c.unchecked_get<int>()), "unchecked_get does not throw");
+}
+
 TEST(any, query_type)
 {
 	static_any<32> a(7);
@@ -530,6 +606,277 @@ TEST(any, type_identification_across_dll)
 	EXPECT_THROW(a.get<std::string>(), bad_any_cast);
 }
 
+TEST(any, type_hash)
+{
+	using namespace detail::static_any;
+
+	static_assert(type_hash_v<int> == type_hash_v<const int&>, "cv-ref qualifiers are not part of the type identity");
+	static_assert(type_hash_v<int> != type_hash_v<unsigned>, "different types have different hashes");
+	static_assert(type_hash_v<std::string> != type_hash_v<std::vector<char>>, "different types have different hashes");
+
+	ASSERT_EQ(type_hash_v<int>, get_function_for_type<int>()->type_hash);
+}
+
+TEST(any, same_name_types)
+{
+	// both lambdas print as the same name, so have the same type hash
+	auto a = [] { return 1; };
+	auto b = [] { return 2; };
+	using LambdaA = decltype(a);
+	using LambdaB = decltype(b);
+	ASSERT_EQ(detail::static_any::type_hash_v<LambdaA>, detail::static_any::type_hash_v<LambdaB>);
+
+	static_any<16> x = a;
+	ASSERT_TRUE(x.has<LambdaA>());
+	ASSERT_FALSE(x.has<LambdaB>());
+	EXPECT_THROW(x.get<LambdaB>(), bad_any_cast);
+
+	const static_any<16> y = b;
+	ASSERT_TRUE(x != y);
+	ASSERT_TRUE((x < y) != (y < x));
+
+	ASSERT_EQ(2, (visit<LambdaA, LambdaB>([](auto f) { return f(); }, y)));
+	ASSERT_EQ(1, (visit<LambdaA, LambdaB>([](auto f) { return f(); }, x)));
+	EXPECT_THROW((visit<int, LambdaB>([](auto) {}, x)), bad_any_cast);
+}
+
+struct Describe
+{
+	std::string operator()(int i) const { return "int " + std::to_string(i); }
+	std::string operator()(double) const { return "double"; }
+	std::string operator()(const std::string& s) const { return "string " + s; }
+
+	template <class _T, class _U>
+	std::string operator()(const _T& t, const _U& u) const { return (*this)(t) + ", " + (*this)(u); }
+};
+
+TEST(any_visit, single)
+{
+	static_any<32> a(7);
+	ASSERT_EQ("int 7", (visit<int, double, std::string>(Describe{}, a)));
+
+	a = std::string("foo");
+	ASSERT_EQ("string foo", (visit<int, double, std::string>(Describe{}, a)));
+
+	const static_any<32> b(.5);
+	ASSERT_EQ("double", (visit<int, double, std::string>(Describe{}, b)));
+}
+
+TEST(any_visit, mutate)
+{
+	static_any<32> a(7);
+	visit<int, double>([](auto& v) { v *= 2; }, a);
+	ASSERT_EQ(14, a.get<int>());
+}
+
+TEST(any_visit, unknown_type)
+{
+	static_any<32> a(7.f);
+	EXPECT_THROW((visit<int, double>(Describe{}, a)), bad_any_cast);
+
+	static_any<32> empty;
+	EXPECT_THROW((visit<int, double>(Describe{}, empty)), bad_any_cast);
+
+	auto fallback = [](const static_any<32>& any) { return std::string("unknown ") + (any.empty() ? "empty" : "float"); };
+	ASSERT_EQ("unknown float", (visit_or<int, double>(Describe{}, fallback, a)));
+	ASSERT_EQ("unknown empty", (visit_or<int, double>(Describe{}, fallback, empty)));
+}
+
+TEST(any_visit, multiple)
+{
+	static_any<32> a(7);
+	static_any<16> b(.5);
+	const static_any<32> c(std::string("foo"));
+
+	ASSERT_EQ("int 7, double", (visit<int, double, std::string>(Describe{}, a, b)));
+	ASSERT_EQ("string foo, int 7", (visit<int, double, std::string>(Describe{}, c, a)));
+	ASSERT_EQ("double, double", (visit<int, double, std::string>(Describe{}, b, b)));
+
+	static_any<16> d(7.f);
+	auto fallback = [](const static_any<32>&, const static_any<16>&) { return std::string("unknown"); };
+	ASSERT_EQ("unknown", (visit_or<int, double, std::string>(Describe{}, fallback, a, d)));
+}
+
+TEST(any_visit, across_dll)
+{
+	auto a = get_any_with_int(7);
+	ASSERT_EQ("int 7", (visit<double, int>(Describe{}, a)));
+}
+
+TEST(any_compare, equal)
+{
+	static_any<16> a(7);
+	static_any<32> b(7);
+	static_any<16> c(7L);
+	static_any<32> e;
+
+	ASSERT_TRUE(a == b);
+	ASSERT_FALSE(a != b);
+	ASSERT_FALSE(a == c); // same value, different types
+	ASSERT_FALSE(a == e);
+	ASSERT_TRUE(e == static_any<8>());
+
+	b = std::string("foo");
+	ASSERT_TRUE(b == static_any<32>(std::string("foo")));
+	ASSERT_FALSE(b == static_any<32>(std::string("bar")));
+
+	ASSERT_TRUE(a == get_any_with_int(7));
+	ASSERT_FALSE(a == get_any_with_int(8));
+}
+
+TEST(any_compare, not_comparable)
+{
+	static_any<16> a(A(1));
+	static_any<16> b(A(1));
+	EXPECT_THROW(a == b, bad_any_comparison);
+
+	// types are compared first
+	ASSERT_FALSE(a == static_any<16>(1));
+}
+
+struct OnlyLess
+{
+	bool operator<(const OnlyLess& other) const { return i < other.i; }
+	int i;
+};
+
+struct NotComparedByAny
+{
+	bool operator==(const NotComparedByAny&) const { return true; }
+};
+
+template <>
+struct static_any_equality_comparable<NotComparedByAny> : std::false_type {};
+
+TEST(any_compare, not_comparable_elements)
+{
+	// the operator== of the containers compiles only if the elements have one
+	static_any<32> v(std::vector<OnlyLess>{{1}});
+	EXPECT_THROW(v == v, bad_any_comparison);
+	ASSERT_FALSE(v < v);
+
+	static_any<32> p(std::make_pair(1, OnlyLess{1}));
+	EXPECT_THROW(p == p, bad_any_comparison);
+
+	static_any<32> t(std::make_tuple(1, std::vector<int>{1}));
+	ASSERT_TRUE(t == t);
+
+	static_any<64> m(std::map<int, std::vector<int>>{{1, {2}}});
+	ASSERT_TRUE(m == m);
+
+	static_any<32> n(NotComparedByAny{});
+	EXPECT_THROW(n == n, bad_any_comparison);
+}
+
+TEST(any_compare, hash)
+{
+	using hash = std::hash<static_any<32>>;
+
+	ASSERT_EQ(hash()(static_any<32>(std::string("foo"))), hash()(static_any<32>(std::string("foo"))));
+	ASSERT_NE(hash()(static_any<32>(1)), hash()(static_any<32>(2)));
+	ASSERT_NE(hash()(static_any<32>(1)), hash()(static_any<32>(1L)));
+	ASSERT_EQ(0, hash()(static_any<32>()));
+
+	ASSERT_EQ(std::hash<static_any<16>>()(get_any_with_int(7)), hash()(static_any<32>(7)));
+	EXPECT_THROW(hash()(static_any<32>(A(1))), bad_any_hash);
+}
+
+TEST(any_compare, less)
+{
+	static_any<16> a(1);
+	static_any<32> b(2);
+
+	ASSERT_TRUE(a < b);
+	ASSERT_TRUE(b > a);
+	ASSERT_TRUE(a <= a);
+	ASSERT_FALSE(a < a);
+	ASSERT_TRUE(static_any<16>() < a);
+	ASSERT_FALSE(a < static_any<16>());
+
+	// values of different types are ordered by their types, consistently
+	static_any<32> s(std::string("a"));
+	ASSERT_NE(a < s, s < a);
+	ASSERT_EQ(a < s, b < s);
+	ASSERT_EQ(a < get_any_with_int(0), false);
+
+	static_any<16> c(A(1));
+	EXPECT_THROW(c < c, bad_any_comparison);
+	ASSERT_NE(c < a, a < c);
+}
+
+TEST(any_compare, not_less_comparable_elements)
+{
+	static_any<32> v(std::vector<A>{A(1)});
+	EXPECT_THROW(v < v, bad_any_comparison);
+
+	static_any<32> p(std::make_pair(1, A(1)));
+	EXPECT_THROW(p < p, bad_any_comparison);
+
+	static_any<32> t(std::make_tuple(1, std::vector<int>{1}));
+	ASSERT_FALSE(t < t);
+}
+
+TEST(any, assign_empty)
+{
+	static_any<16> a(7);
+	a = static_any<16>();
+	ASSERT_TRUE(a.empty());
+
+	static_any<32> b(std::string("foo"));
+	b = static_any<16>();
+	ASSERT_TRUE(b.empty());
+}
+
+// assigning an empty any destroys the stored value, by copy or move, from the same or a smaller capacity
+TEST(any, assign_empty_destroys_value)
+{
+	using counter = CallCounter<2>;
+	counter::reset_counters();
+
+	static_any<32> a(counter{});
+	static_any<32> b(counter{});
+	static_any<32> c(counter{});
+	counter::reset_counters();
+
+	const static_any<32> empty;
+	a = empty;
+	ASSERT_TRUE(a.empty());
+	ASSERT_EQ(1, counter::destructions);
+
+	b = static_any<16>();
+	ASSERT_TRUE(b.empty());
+	ASSERT_EQ(2, counter::destructions);
+
+	static_any<16> moved_empty;
+	c = std::move(moved_empty);
+	ASSERT_TRUE(c.empty());
+	ASSERT_EQ(3, counter::destructions);
+
+	// an empty any assigned to itself stays empty
+	a = a;
+	ASSERT_TRUE(a.empty());
+	ASSERT_EQ(0, counter::constructions + counter::copy_constructions + counter::move_constructions);
+}
+
+TEST(any_compare, sort_and_map)
+{
+	std::vector<static_any<32>> values = { 3, std::string("b"), 1.5, 1, std::string("a"), static_any<32>(), 2 };
+	std::sort(values.begin(), values.end());
+
+	ASSERT_TRUE(values[0].empty());
+	ASSERT_TRUE(std::is_sorted(values.begin(), values.end(), static_any_less()));
+	ASSERT_TRUE(std::binary_search(values.begin(), values.end(), static_any<16>(2), static_any_less()));
+	ASSERT_FALSE(std::binary_search(values.begin(), values.end(), static_any<16>(4), static_any_less()));
+
+	std::map<static_any<32>, int, static_any_less> m;
+	m[1] = 10;
+	m[std::string("1")] = 20;
+	m[1L] = 30;
+	ASSERT_EQ(3, m.size());
+	ASSERT_EQ(10, m.find(static_any<16>(1))->second);
+	ASSERT_EQ(20, m[std::string("1")]);
+}
+
 TEST(any_t, simple)
 {
 	static_any_t<16> a(7);
@@ -590,14 +937,145 @@ private:
 
 
 TEST(any, assignment_strong_guarantee)
+{
+	static_any<16> a(5);
+	UnsafeMove u(42);
+
+	EXPECT_THROW(a = u, std::runtime_error);
+
+	ASSERT_FALSE(a.empty());
+	EXPECT_EQ(5, a.get<int>());
+}
+
+TEST(any, nothrow_assignment_no_backup)
 {
 	static_any<16> a(UnsafeCopy(42));
 
+	EXPECT_NO_THROW(a = 5);
+	EXPECT_EQ(5, a.get<int>());
+}
+
+TEST(any, nothrow_value_assignment_no_backup)
+{
+	static_any<32> a = CallCounter<0>();
+
 	CallCounter<0>::reset_counters();
-	EXPECT_THROW(a = 5, std::runtime_error);
+	a = std::string("foobar");
 
-	ASSERT_FALSE(a.empty());
-	EXPECT_EQ(42, a.get<UnsafeCopy>().get());
+	ASSERT_EQ(0, CallCounter<0>::copy_constructions);
+	ASSERT_EQ(0, CallCounter<0>::move_constructions);
+	ASSERT_EQ(1, CallCounter<0>::destructions);
+	ASSERT_EQ("foobar", a.get<std::string>());
+}
+
+TEST(any, nothrow_any_assignment_no_backup)
+{
+	static_any<32> a = CallCounter<0>();
+	static_any<32> b = std::string("foobar");
+
+	CallCounter<0>::reset_counters();
+	a = std::move(b);
+
+	ASSERT_EQ(0, CallCounter<0>::copy_constructions);
+	ASSERT_EQ(0, CallCounter<0>::move_constructions);
+	ASSERT_EQ(1, CallCounter<0>::destructions);
+	ASSERT_EQ("foobar", a.get<std::string>());
+}
+
+TEST(any, throwing_assignment_to_empty_no_backup)
+{
+	static_any<16> a;
+	static_any<16> b = CallCounter<0>();
+
+	CallCounter<0>::reset_counters();
+	a = b;
+
+	ASSERT_EQ(1, CallCounter<0>::copy_constructions);
+	ASSERT_EQ(0, CallCounter<0>::move_constructions);
+	ASSERT_EQ(0, CallCounter<0>::destructions);
+}
+
+TEST(any, self_assignment)
+{
+	static_any<32> a = std::string("foobar");
+	auto& ref = a;
+	a = ref;
+
+	ASSERT_EQ("foobar", a.get<std::string>());
+}
+
+TEST(any_swap, values)
+{
+	static_any<32> a = std::string("foo");
+	static_any<32> b = std::string("bar");
+	a.swap(b);
+	ASSERT_EQ("bar", a.get<std::string>());
+	ASSERT_EQ("foo", b.get<std::string>());
+
+	static_any<32> c = 7;
+	swap(a, c);
+	ASSERT_EQ(7, a.get<int>());
+	ASSERT_EQ("bar", c.get<std::string>());
+
+	static_any<32> d;
+	using std::swap;
+	swap(c, d);
+	ASSERT_TRUE(c.empty());
+	ASSERT_EQ("bar", d.get<std::string>());
+
+	swap(c, c);
+	ASSERT_TRUE(c.empty());
+}
+
+TEST(any_swap, trivial)
+{
+	static_any<16> a = 1.5;
+	static_any<16> b = 'x';
+	swap(a, b);
+	ASSERT_EQ('x', a.get<char>());
+	ASSERT_EQ(1.5, b.get<double>());
+}
+
+TEST(any_swap, different_capacities)
+{
+	static_any<32> a = 1;
+	static_any<64> b = std::string("foo");
+	swap(a, b);
+	ASSERT_EQ("foo", a.get<std::string>());
+	ASSERT_EQ(1, b.get<int>());
+
+	struct Big { char data[48]; };
+	b = Big{};
+	EXPECT_THROW(swap(a, b), std::length_error);
+	ASSERT_EQ("foo", a.get<std::string>());
+	ASSERT_TRUE(b.has<Big>());
+}
+
+TEST(any_swap, moves_only)
+{
+	static_any<16> a = CallCounter<0>();
+	static_any<16> b = CallCounter<1>();
+
+	CallCounter<0>::reset_counters();
+	CallCounter<1>::reset_counters();
+
+	swap(a, b);
+	ASSERT_TRUE(a.has<CallCounter<1>>());
+	ASSERT_TRUE(b.has<CallCounter<0>>());
+
+	// to the scratch buffer and back for the first one, once for the second one, without any backup
+	ASSERT_EQ(0, CallCounter<0>::copy_constructions);
+	ASSERT_EQ(2, CallCounter<0>::move_constructions);
+	ASSERT_EQ(2, CallCounter<0>::destructions);
+	ASSERT_EQ(0, CallCounter<1>::copy_constructions);
+	ASSERT_EQ(1, CallCounter<1>::move_constructions);
+	ASSERT_EQ(1, CallCounter<1>::destructions);
+
+	static_any<16> p = std::make_unique<int>(1);
+	static_any<16> q = std::make_unique<int>(2);
+	swap(p, q);
+	ASSERT_EQ(2, *p.get<std::unique_ptr<int>>());
+	ASSERT_EQ(1, *q.get<std::unique_ptr<int>>());
 }
 
 TEST(any_exception, init)
@@ -679,3 +1157,637 @@ TEST(any_exception, move_from_different_any)
 }
 
 
+
+TEST(any_move_only, construct)
+{
+	static_any<16> a(std::make_unique<int>(7));
+
+	ASSERT_TRUE(a.has<std::unique_ptr<int>>());
+	ASSERT_EQ(7, *a.get<std::unique_ptr<int>>());
+}
+
+TEST(any_move_only, emplace)
+{
+	static_any<16> a;
+	a.emplace<std::unique_ptr<int>>(new int(7));
+
+	ASSERT_EQ(7, *a.get<std::unique_ptr<int>>());
+}
+
+TEST(any_move_only, move_to_bigger_any)
+{
+	static_any<16> a(std::make_unique<int>(7));
+	const int* p = a.get<std::unique_ptr<int>>().get();
+
+	static_any<32> b(std::move(a));
+	ASSERT_EQ(p, b.get<std::unique_ptr<int>>().get());
+	ASSERT_EQ(nullptr, a.get<std::unique_ptr<int>>());
+
+	static_any<32> c(1234);
+	c = std::move(b);
+	ASSERT_EQ(p, c.get<std::unique_ptr<int>>().get());
+}
+
+TEST(any_move_only, copy_throws)
+{
+	static_any<16> a(std::make_unique<int>(7));
+	EXPECT_THROW(static_any<16> b(a), bad_any_copy);
+
+	static_any<16> c(1234);
+	EXPECT_THROW(c = a, bad_any_copy);
+	EXPECT_EQ(1234, c.get<int>());
+	EXPECT_EQ(7, *a.get<std::unique_ptr<int>>());
+}
+
+TEST(any_move_only, copy_error)
+{
+	static_any<16> a(std::make_unique<int>(7));
+
+	try {
+		static_any<16> b(a);
+		FAIL();
+	}
+	catch(bad_any_copy& ex) {
+		ASSERT_EQ(typeid(std::unique_ptr<int>), ex.stored_type());
+	}
+}
+
+struct MoveOnly
+{
+	explicit MoveOnly(int i) :
+		__i(i) {}
+
+	MoveOnly(const MoveOnly&) = delete;
+	MoveOnly(MoveOnly&& m) :
+		__i(m.__i) {}
+
+	int __i;
+};
+
+TEST(any_move_only, assignment_strong_guarantee)
+{
+	static_any<16> a(MoveOnly(7));
+	UnsafeMove u(42);
+
+	EXPECT_THROW(a = u, std::runtime_error);
+	EXPECT_EQ(7, a.get<MoveOnly>().__i);
+}
+
+struct Pod
+{
+	long l;
+	double d;
+};
+
+TEST(any_trivial, copy)
+{
+	static_any<32> a(Pod{7, .5});
+	static_any<32> b(a);
+
+	ASSERT_TRUE(b.has<Pod>());
+	ASSERT_FALSE(b.has<int>());
+	EXPECT_EQ(7, b.get<Pod>().l);
+	EXPECT_EQ(.5, b.get<Pod>().d);
+	EXPECT_EQ(sizeof(Pod), b.size());
+}
+
+TEST(any_trivial, assign_to_bigger_any)
+{
+	static_any<16> a(Pod{7, .5});
+	static_any<64> b(std::string("foobar"));
+
+	b = a;
+	ASSERT_TRUE(b.has<Pod>());
+	EXPECT_EQ(7, b.get<Pod>().l);
+
+	b = std::move(a);
+	EXPECT_EQ(.5, b.get<Pod>().d);
+}
+
+TEST(any_trivial, vector_copy)
+{
+	std::vector<static_any<32>> v{Pod{1, .5}, 2, std::string("foobar"), 3.5};
+	auto w = v;
+
+	EXPECT_EQ(1, w[0].get<Pod>().l);
+	EXPECT_EQ(2, w[1].get<int>());
+	EXPECT_EQ("foobar", w[2].get<std::string>());
+	EXPECT_EQ(3.5, w[3].get<double>());
+	EXPECT_THROW(w[3].get<int>(), bad_any_cast);
+}
+
+struct Relocatable
+{
+	explicit Relocatable(int i) : p(new int(i)) {}
+	Relocatable(const Relocatable& r) : p(new int(*r.p)) { ++copies; }
+	Relocatable(Relocatable&& r) noexcept : p(std::move(r.p)) { ++moves; }
+	~Relocatable() { ++destructions; }
+
+	static void reset_counters() { copies = moves = destructions = 0; }
+
+	std::unique_ptr<int> p;
+
+	static int copies;
+	static int moves;
+	static int destructions;
+};
+
+int Relocatable::copies = 0;
+int Relocatable::moves = 0;
+int Relocatable::destructions = 0;
+
+template <>
+struct static_any_trivially_relocatable<Relocatable> : std::true_type {};
+
+TEST(any_relocatable, move)
+{
+	static_any<16> a = Relocatable(7);
+	Relocatable::reset_counters();
+
+	static_any<16> b(std::move(a));
+	ASSERT_TRUE(a.empty());
+	ASSERT_EQ(7, *b.get<Relocatable>().p);
+
+	static_any<32> c;
+	c = std::move(b);
+	ASSERT_TRUE(b.empty());
+	ASSERT_EQ(7, *c.get<Relocatable>().p);
+
+	static_any<32> d = std::string("foo");
+	swap(c, d);
+	ASSERT_EQ(7, *d.get<Relocatable>().p);
+
+	ASSERT_EQ(0, Relocatable::copies);
+	ASSERT_EQ(0, Relocatable::moves);
+	ASSERT_EQ(0, Relocatable::destructions);
+
+	d.reset();
+	ASSERT_EQ(1, Relocatable::destructions);
+}
+
+TEST(any_relocatable, vector_growth)
+{
+	static_assert(std::is_nothrow_move_constructible<static_any<16>>::value, "moved by std::vector");
+
+	std::vector<static_any<16>> v;
+	v.emplace_back(Relocatable(0));
+	Relocatable::reset_counters();
+
+	for (int i = 1; i < 100; ++i)
+		v.emplace_back(Relocatable(i));
+
+	// one move per element, from the temporary Relocatable to its any
+	ASSERT_EQ(0, Relocatable::copies);
+	ASSERT_EQ(99, Relocatable::moves);
+	ASSERT_EQ(99, Relocatable::destructions);
+
+	for (int i = 0; i < 100; ++i)
+		ASSERT_EQ(i, *v[static_cast<std::size_t>(i)].get<Relocatable>().p);
+}
+
+TEST(any_checked_t, sizeof)
+{
+	static_assert(sizeof(checked_static_any_t<15>) == 15 + 1, "one byte tag");
+	static_assert(sizeof(checked_static_any_t<14, std::uint16_t>) == 14 + 2, "two bytes tag");
+	static_assert(sizeof(checked_static_any_t<16, std::uint8_t, 1>) == 16 + 1, "one byte tag");
+	static_assert(std::is_trivially_copyable<checked_static_any_t<16>>::value, "trivially copyable");
+}
+
+TEST(any_checked_t, get)
+{
+	checked_static_any_t<16> a(7);
+	ASSERT_TRUE(a.has<int>());
+	ASSERT_TRUE(a.has<const int>());
+	ASSERT_EQ(7, a.get<int>());
+
+	a = Pod{1, .5};
+	ASSERT_FALSE(a.has<int>());
+	ASSERT_EQ(1, a.get<Pod>().l);
+	ASSERT_EQ(typeid(Pod), a.type());
+}
+
+TEST(any_checked_t, get_bad_type)
+{
+	checked_static_any_t<16> a(7);
+	EXPECT_THROW(a.get<float>(), bad_any_cast);
+
+	try {
+		a.get<float>();
+		FAIL();
+	}
+	catch(bad_any_cast& ex) {
+		ASSERT_EQ(typeid(int), ex.stored_type());
+		ASSERT_EQ(typeid(float), ex.target_type());
+	}
+}
+
+TEST(any_checked_t, empty)
+{
+	checked_static_any_t<16> a;
+	ASSERT_TRUE(a.empty());
+	ASSERT_EQ(typeid(void), a.type());
+	EXPECT_THROW(a.get<int>(), bad_any_cast);
+
+	a = 7;
+	ASSERT_FALSE(a.empty());
+
+	a.reset();
+	ASSERT_TRUE(a.empty());
+}
+
+TEST(any_checked_t, copy)
+{
+	checked_static_any_t<16> a(7);
+	checked_static_any_t<16> b(a);
+	checked_static_any_t<16> c;
+	std::memcpy(&c, &a, sizeof(a));
+
+	ASSERT_EQ(7, b.get<int>());
+	ASSERT_EQ(7, c.get<int>());
+	ASSERT_EQ(a.tag(), c.tag());
+}
+
+TEST(compact_any, sizeof)
+{
+	static_assert(sizeof(compact_static_any<15>) == 16, "one byte header");
+	static_assert(sizeof(compact_static_any<14, std::uint16_t>) == 16, "two bytes header");
+	static_assert(sizeof(compact_static_any<8, std::uint8_t, 1>) == 9, "one byte header");
+	static_assert(sizeof(compact_static_any<8, std::uint8_t, 2>) == 10, "one byte header, padded to 2 bytes");
+	static_assert(sizeof(compact_static_any<8, std::uint16_t, 2>) == 10, "two bytes header");
+	static_assert(sizeof(compact_static_any<8, std::uint8_t, 4>) == 12, "one byte header, padded to 4 bytes");
+}
+
+TEST(compact_any, get)
+{
+	compact_static_any<47> a;
+	ASSERT_TRUE(a.empty());
+	ASSERT_FALSE(a.has<int>());
+	ASSERT_EQ(typeid(void), a.type());
+	ASSERT_EQ(0, a.size());
+
+	a = 7;
+	ASSERT_TRUE(a.has<int>());
+	ASSERT_TRUE(a.has<const int>());
+	ASSERT_FALSE(a.has<long>());
+	ASSERT_EQ(7, a.get<int>());
+	ASSERT_EQ(sizeof(int), a.size());
+
+	a = std::string("foobar");
+	ASSERT_EQ("foobar", a.get<std::string>());
+	ASSERT_EQ(typeid(std::string), a.type());
+	EXPECT_THROW(a.get<int>(), bad_any_cast);
+
+	a.reset();
+	ASSERT_TRUE(a.empty());
+}
+
+TEST(compact_any, try_get)
+{
+	compact_static_any<32> a(std::string("foobar"));
+	ASSERT_EQ("foobar", *a.try_get<std::string>());
+	ASSERT_EQ(nullptr, a.try_get<int>());
+	ASSERT_EQ("foobar", a.unchecked_get<std::string>());
+
+	checked_static_any_t<8> b(7);
+	ASSERT_EQ(7, *b.try_get<int>());
+	ASSERT_EQ(nullptr, b.try_get<float>());
+	ASSERT_EQ(7, b.unchecked_get<int>());
+
+	hybrid_static_any<16> c(std::string("foobar"));
+	ASSERT_EQ("foobar", *c.try_get<std::string>());
+	ASSERT_EQ(nullptr, c.try_get<int>());
+	c.unchecked_get<std::string>() += "!";
+	ASSERT_EQ("foobar!", c.get<std::string>());
+}
+
+TEST(compact_any, copy_and_move)
+{
+	compact_static_any<47> a(std::string("foobar"));
+	compact_static_any<47> b(a);
+	compact_static_any<63> c(std::move(a));
+
+	ASSERT_EQ("foobar", b.get<std::string>());
+	ASSERT_EQ("foobar", c.get<std::string>());
+
+	compact_static_any<63> d(1234);
+	d = b;
+	ASSERT_EQ("foobar", d.get<std::string>());
+
+	d = compact_static_any<47>();
+	ASSERT_TRUE(d.empty());
+}
+
+TEST(compact_any, destruction)
+{
+	CallCounter<0>::reset_counters();
+	{
+		compact_static_any<15> a;
+		a.emplace<CallCounter<0>>();
+
+		compact_static_any<15> b(a);
+		b = 7;
+	}
+
+	EXPECT_EQ(1, CallCounter<0>::constructions);
+	EXPECT_EQ(1, CallCounter<0>::copy_constructions);
+	EXPECT_EQ(2, CallCounter<0>::destructions);
+}
+
+TEST(compact_any, move_only)
+{
+	compact_static_any<15> a(std::make_unique<int>(7));
+	compact_static_any<15> b(std::move(a));
+
+	ASSERT_EQ(7, *b.get<std::unique_ptr<int>>());
+	EXPECT_THROW(compact_static_any<15> c(b), bad_any_copy);
+}
+
+TEST(compact_any, vector_growth)
+{
+	static_assert(std::is_nothrow_move_constructible<compact_static_any<15>>::value, "moved by std::vector");
+
+	std::vector<compact_static_any<15>> v;
+	for (int i = 0; i < 100; ++i)
+		v.emplace_back(std::make_unique<int>(i));
+
+	for (int i = 0; i < 100; ++i)
+		ASSERT_EQ(i, *v[static_cast<std::size_t>(i)].get<std::unique_ptr<int>>());
+}
+
+TEST(compact_any, assignment_strong_guarantee)
+{
+	compact_static_any<15> a(5);
+	UnsafeMove u(42);
+
+	EXPECT_THROW(a = u, std::runtime_error);
+	EXPECT_EQ(5, a.get<int>());
+
+	compact_static_any<15> b(UnsafeMove(1));
+	compact_static_any<15> c;
+	c.emplace<UnsafeMove>(42);
+
+	EXPECT_THROW(b = c, std::runtime_error);
+	EXPECT_EQ(1, b.get<UnsafeMove>().get());
+}
+
+using Big = std::array<char, 64>;
+
+struct AllocationCounters
+{
+	static int allocations;
+	static int deallocations;
+};
+
+int AllocationCounters::allocations = 0;
+int AllocationCounters::deallocations = 0;
+
+template <class _T>
+struct CountingAllocator
+{
+	using value_type = _T;
+
+	explicit CountingAllocator(int i = 0) :
+		id(i)
+	{}
+
+	template <class _U>
+	CountingAllocator(const CountingAllocator<_U>& other) :
+		id(other.id)
+	{}
+
+	_T* allocate(std::size_t n)
+	{
+		++AllocationCounters::allocations;
+		return static_cast<_T*>(::operator new(n * sizeof(_T)));
+	}
+
+	void deallocate(_T* p, std::size_t)
+	{
+		++AllocationCounters::deallocations;
+		::operator delete(p);
+	}
+
+	int id;
+};
+
+template <class _T, class _U>
+bool operator==(const CountingAllocator<_T>& a, const CountingAllocator<_U>& b) { return a.id == b.id; }
+
+template <class _T, class _U>
+bool operator!=(const CountingAllocator<_T>& a, const CountingAllocator<_U>& b) { return a.id != b.id; }
+
+// shared by the rebound allocators
+static bool fail_allocations = false;
+
+template <class _T>
+struct FailingAllocator
+{
+	using value_type = _T;
+
+	FailingAllocator() = default;
+
+	template <class _U>
+	FailingAllocator(const FailingAllocator<_U>&) {}
+
+	_T* allocate(std::size_t n)
+	{
+		if (fail_allocations)
+			throw std::bad_alloc();
+		return static_cast<_T*>(::operator new(n * sizeof(_T)));
+	}
+
+	void deallocate(_T* p, std::size_t) { ::operator delete(p); }
+};
+
+template <class _T, class _U>
+bool operator==(const FailingAllocator<_T>&, const FailingAllocator<_U>&) { return true; }
+
+template <class _T, class _U>
+bool operator!=(const FailingAllocator<_T>&, const FailingAllocator<_U>&) { return false; }
+
+TEST(hybrid_any, sizeof)
+{
+	static_assert(sizeof(hybrid_static_any<16>) == sizeof(static_any<16>), "std::allocator takes no space");
+	static_assert(sizeof(hybrid_static_any<16, std::allocator<char>, 8>) == 16 + sizeof(void*), "std::allocator takes no space");
+}
+
+TEST(hybrid_any, inline_and_spilled)
+{
+	hybrid_static_any<16> a(7);
+	ASSERT_FALSE(a.spilled());
+	ASSERT_EQ(7, a.get<int>());
+
+	Big big;
+	big.fill('x');
+	a = big;
+	ASSERT_TRUE(a.spilled());
+	ASSERT_EQ(big, a.get<Big>());
+	ASSERT_EQ(sizeof(Big), a.size());
+	ASSERT_EQ(typeid(Big), a.type());
+	EXPECT_THROW(a.get<int>(), bad_any_cast);
+
+	a = std::string(100, 'y');
+	ASSERT_TRUE(a.spilled());
+	ASSERT_EQ(std::string(100, 'y'), a.get<std::string>());
+
+	a.reset();
+	ASSERT_TRUE(a.empty());
+	ASSERT_FALSE(a.spilled());
+}
+
+TEST(hybrid_any, move_transfers_pointer)
+{
+	hybrid_static_any<16> a(Big{});
+	const Big* value = &a.get<Big>();
+
+	hybrid_static_any<16> b(std::move(a));
+	ASSERT_TRUE(a.empty());
+	ASSERT_EQ(value, &b.get<Big>());
+
+	hybrid_static_any<32> c(std::move(b));
+	ASSERT_EQ(value, &c.get<Big>());
+
+	hybrid_static_any<8> d;
+	d = std::move(c);
+	ASSERT_EQ(value, &d.get<Big>());
+
+	// fits in the buffer: moved in it
+	hybrid_static_any<64> e(std::move(d));
+	ASSERT_TRUE(d.empty());
+	ASSERT_FALSE(e.spilled());
+}
+
+TEST(hybrid_any, allocator)
+{
+	using any_type = hybrid_static_any<16, CountingAllocator<char>>;
+
+	AllocationCounters::allocations = 0;
+	AllocationCounters::deallocations = 0;
+	{
+		any_type a(std::allocator_arg, CountingAllocator<char>(1), Big{});
+		ASSERT_EQ(1, AllocationCounters::allocations);
+
+		any_type b(a);
+		ASSERT_EQ(2, AllocationCounters::allocations);
+
+		any_type c(std::move(a));
+		ASSERT_EQ(2, AllocationCounters::allocations);
+		ASSERT_EQ(1, c.get_allocator().id);
+
+		// the allocators differ: the value is moved to memory of the target allocator
+		any_type d(CountingAllocator<char>(2));
+		d = std::move(c);
+		ASSERT_EQ(3, AllocationCounters::allocations);
+		ASSERT_EQ(1, AllocationCounters::deallocations);
+		ASSERT_EQ(2, d.get_allocator().id);
+
+		d = 7;
+		ASSERT_EQ(2, AllocationCounters::deallocations);
+	}
+	ASSERT_EQ(AllocationCounters::allocations, AllocationCounters::deallocations);
+}
+
+TEST(hybrid_any, destruction)
+{
+	struct BigCounter
+	{
+		CallCounter<1> counter;
+		Big data;
+	};
+
+	CallCounter<1>::reset_counters();
+	{
+		hybrid_static_any<16> a;
+		a.emplace<BigCounter>();
+
+		hybrid_static_any<16> b(a);
+		hybrid_static_any<16> c(std::move(a));
+		b = 7;
+	}
+
+	EXPECT_EQ(1, CallCounter<1>::constructions);
+	EXPECT_EQ(1, CallCounter<1>::copy_constructions);
+	EXPECT_EQ(0, CallCounter<1>::move_constructions);
+	EXPECT_EQ(2, CallCounter<1>::destructions);
+}
+
+TEST(hybrid_any, move_only)
+{
+	hybrid_static_any<8> a(std::make_unique<int>(7));
+	hybrid_static_any<8> b(std::move(a));
+
+	ASSERT_EQ(7, *b.get<std::unique_ptr<int>>());
+	EXPECT_THROW(hybrid_static_any<8> c(b), bad_any_copy);
+}
+
+TEST(hybrid_any, vector_growth)
+{
+	static_assert(std::is_nothrow_move_constructible<hybrid_static_any<8>>::value, "moved by std::vector");
+
+	// inline and spilled move only values
+	using Spilled = std::pair<std::unique_ptr<int>, int>;
+	std::vector<hybrid_static_any<8>> v;
+	for (int i = 0; i < 100; ++i)
+	{
+		if (i % 2 == 0)
+			v.emplace_back(std::make_unique<int>(i));
+		else
+			v.emplace_back(Spilled(std::make_unique<int>(i), 0));
+	}
+
+	for (int i = 0; i < 100; i += 2)
+	{
+		ASSERT_EQ(i, *v[static_cast<std::size_t>(i)].get<std::unique_ptr<int>>());
+		ASSERT_EQ(i + 1, *v[static_cast<std::size_t>(i + 1)].get<Spilled>().first);
+	}
+}
+
+TEST(hybrid_any, assignment_strong_guarantee)
+{
+	UnsafeMove u(42);
+
+	hybrid_static_any<16> a(5);
+	EXPECT_THROW(a = u, std::runtime_error);
+	EXPECT_EQ(5, a.get<int>());
+
+	hybrid_static_any<16> b(Big{});
+	const Big* value = &b.get<Big>();
+	EXPECT_THROW(b = u, std::runtime_error);
+	EXPECT_EQ(value, &b.get<Big>());
+}
+
+TEST(hybrid_any, assignment_strong_guarantee_failed_allocation)
+{
+	// Big is nothrow copy constructible, but spilled
+	hybrid_static_any<16, FailingAllocator<char>> a(5);
+
+	fail_allocations = true;
+	EXPECT_THROW(a = Big{}, std::bad_alloc);
+	fail_allocations = false;
+
+	EXPECT_EQ(5, a.get<int>());
+}
+
+TEST(hybrid_any, over_aligned_not_spilled)
+{
+	struct alignas(64) OverAligned { double d; };
+	using aligned_any = hybrid_static_any<64, std::allocator<char>, 64>;
+
+	aligned_any a(OverAligned{1.5});
+	ASSERT_FALSE(a.spilled());
+
+	// stored inline in a, but too aligned to be allocated by a hybrid_static_any<16>
+	EXPECT_THROW(hybrid_static_any<16> b(a), bad_any_alignment);
+	EXPECT_THROW(hybrid_static_any<16> c(std::move(a)), bad_any_alignment);
+	ASSERT_EQ(1.5, a.get<OverAligned>().d);
+
+	hybrid_static_any<16> d(7);
+	EXPECT_THROW(d = a, bad_any_alignment);
+	ASSERT_EQ(7, d.get<int>());
+
+	// the values of other types are spilled as usual
+	a = Big{};
+	d = a;
+	ASSERT_TRUE(d.spilled());
+	ASSERT_EQ(sizeof(Big), d.size());
+}